@@ -0,0 +1,150 @@
+#include <screeps/position.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Tower and rampart coverage loops over `with_range` and `within_range`: the iterators, the
+// `for_each_index` walks over precomputed offsets, and a baseline which evaluates the ring formula
+// for every position. Build with `make coverage`.
+using namespace screeps;
+
+constexpr int k_towers = 6;
+constexpr int k_ramparts = 400;
+constexpr int k_iterations = 2000;
+
+template <class Function>
+double time_us(Function function) {
+	auto start = std::chrono::steady_clock::now();
+	for (int ii = 0; ii < k_iterations; ++ii) {
+		function();
+	}
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / k_iterations;
+}
+
+// Tower damage at range, from the game's falloff constants
+int tower_damage(int range) {
+	return 600 - 450 * std::clamp(range - 5, 0, 15) / 15;
+}
+
+// Ring walk the way `with_range_iterable_t` worked before the offset tables
+template <class Function>
+void formula_ring(local_position_t origin, int range, Function function) {
+	for (int ii = 0; ii < range * 8; ++ii) {
+		int xx = origin.xx + detail::ring_offset(range, ii + range);
+		int yy = origin.yy + detail::ring_offset(range, ii - range);
+		if (xx >= 0 && xx < 50 && yy >= 0 && yy < 50) {
+			function(xx * 50 + yy);
+		}
+	}
+}
+
+int main() {
+	std::mt19937 random_engine(1);
+	auto random_position = [&]() {
+		return local_position_t(random_engine() % 50, random_engine() % 50);
+	};
+	std::vector<local_position_t> towers(k_towers);
+	std::vector<local_position_t> ramparts(k_ramparts);
+	for (auto& pos : towers) {
+		pos = random_position();
+	}
+	for (auto& pos : ramparts) {
+		pos = random_position();
+	}
+	local_matrix_t<int32_t> damage;
+	local_matrix_t<uint8_t> coverage;
+	int32_t checksum = 0;
+	int mismatches = 0;
+
+	auto check = [&](int32_t& expected, int32_t actual) {
+		if (expected == 0) {
+			expected = actual;
+		} else if (expected != actual) {
+			++mismatches;
+		}
+	};
+	auto damage_sum = [&]() {
+		int32_t sum = 0;
+		for (auto pos : local_position_t::all()) {
+			sum += damage[pos];
+		}
+		return sum;
+	};
+	auto coverage_sum = [&]() {
+		int32_t sum = 0;
+		for (auto pos : local_position_t::all()) {
+			sum += coverage[pos];
+		}
+		return sum;
+	};
+	auto report = [&](const char* name, double baseline, double iterator, double table) {
+		std::cout <<name <<": formula " <<baseline <<"us, iterator " <<iterator <<"us, table " <<table
+			<<"us, " <<(baseline / table) <<"x\n";
+	};
+
+	// Tower damage by ring, out to the edge of the offset tables
+	int32_t expected = 0;
+	auto towers_with = [&](auto ring) {
+		return time_us([&]() {
+			damage.fill(0);
+			for (auto tower : towers) {
+				damage[tower] += tower_damage(0);
+				for (int range = 1; range <= detail::k_ring_table_max_range; ++range) {
+					ring(tower, range, tower_damage(range));
+				}
+			}
+			checksum += damage[towers[0]];
+		});
+	};
+	double baseline = towers_with([&](local_position_t tower, int range, int amount) {
+		formula_ring(tower, range, [&](int index) { damage[index] += amount; });
+	});
+	check(expected, damage_sum());
+	double iterator = towers_with([&](local_position_t tower, int range, int amount) {
+		for (auto pos : tower.with_range(range)) {
+			damage[pos] += amount;
+		}
+	});
+	check(expected, damage_sum());
+	double table = towers_with([&](local_position_t tower, int range, int amount) {
+		tower.with_range(range).for_each_index([&](int index) { damage[index] += amount; });
+	});
+	check(expected, damage_sum());
+	report("tower rings", baseline, iterator, table);
+
+	// Number of ramparts covering each tile within range 3
+	expected = 0;
+	auto ramparts_with = [&](auto area) {
+		return time_us([&]() {
+			coverage.fill(0);
+			for (auto rampart : ramparts) {
+				area(rampart);
+			}
+			checksum += coverage[ramparts[0]];
+		});
+	};
+	baseline = ramparts_with([&](local_position_t rampart) {
+		coverage[rampart] += 1;
+		for (int range = 1; range <= 3; ++range) {
+			formula_ring(rampart, range, [&](int index) { coverage[index] += 1; });
+		}
+	});
+	check(expected, coverage_sum());
+	iterator = ramparts_with([&](local_position_t rampart) {
+		for (auto pos : rampart.within_range(3)) {
+			coverage[pos] += 1;
+		}
+	});
+	check(expected, coverage_sum());
+	table = ramparts_with([&](local_position_t rampart) {
+		rampart.within_range(3).for_each_index([&](int index) { coverage[index] += 1; });
+	});
+	check(expected, coverage_sum());
+	report("rampart areas", baseline, iterator, table);
+
+	std::cout <<mismatches <<" mismatches, checksum " <<checksum <<"\n";
+	return mismatches == 0 ? 0 : 1;
+}
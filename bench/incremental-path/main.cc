@@ -0,0 +1,100 @@
+#include <screeps/incremental-path.h>
+#include <screeps/path-finder.h>
+#include <screeps/terrain.h>
+#include <iostream>
+#include <random>
+
+// Native benchmark of D* Lite repairs. Build with `make incremental-path`.
+//
+// Each trial walks a creep toward a random goal in a room with 20% walls and 20% swamp. After every
+// step one tile on the remaining path is blocked and three random cells change, and the repaired
+// path is compared against a fresh A* search from the creep's position. Costs must match exactly,
+// and ops are totaled for every step after the first.
+using namespace screeps;
+
+constexpr int k_trials = 40;
+constexpr int k_steps = 30;
+
+// Terrain can only be inserted into the cache by subclasses or `game_state_t`
+struct bench_terrain_t : terrain_t {
+	static void insert(room_location_t room, std::shared_ptr<terrain_t> terrain) {
+		terrain_t::insert(room, std::move(terrain));
+	}
+};
+
+int main() {
+	std::mt19937 random_engine(5);
+	room_location_t room(0, 0);
+	auto terrain = std::make_shared<terrain_t>();
+	for (int ii = 0; ii < 2500; ++ii) {
+		int roll = random_engine() % 10;
+		(*terrain)[ii] = roll < 2 ? terrain_t::wall : (roll < 4 ? terrain_t::swamp : terrain_t::plain);
+	}
+	for (int ii = 0; ii < 50; ++ii) {
+		terrain->set(0, ii, terrain_t::wall);
+		terrain->set(49, ii, terrain_t::wall);
+		terrain->set(ii, 0, terrain_t::wall);
+		terrain->set(ii, 49, terrain_t::wall);
+	}
+	bench_terrain_t::insert(room, terrain);
+
+	int steps = 0;
+	int mismatches = 0;
+	int64_t repair_ops = 0;
+	int64_t search_ops = 0;
+	for (int trial = 0; trial < k_trials; ++trial) {
+		cost_matrix_t cost_matrix(0);
+		position_t pos(room, 2 + random_engine() % 46, 2 + random_engine() % 46);
+		position_t goal(room, 2 + random_engine() % 46, 2 + random_engine() % 46);
+		path_finder_t::goals_t goals{{goal, 1}};
+		path_finder_t::options_t options;
+		options.heuristic_weight = 1;
+		options.max_ops = 100000;
+		options.engine = path_finder_t::engine_t::astar;
+		options.room_callback = [&](room_location_t location) -> const cost_matrix_t* {
+			return location == room ? &cost_matrix : nullptr;
+		};
+		incremental_path_t incremental(pos, goals, cost_matrix, options);
+		for (int step = 0; step < k_steps; ++step) {
+			auto fresh = path_finder_t::search(pos, goals, options);
+			auto repaired = incremental.path();
+			if (step > 0) {
+				++steps;
+				repair_ops += incremental.last_ops();
+				search_ops += fresh.ops;
+			}
+			if (fresh.incomplete != repaired.incomplete || (!fresh.incomplete && fresh.cost != repaired.cost)) {
+				++mismatches;
+				break;
+			}
+			auto direction = incremental.next_direction();
+			if (!direction) {
+				break;
+			}
+			pos = pos.in_direction(*direction);
+			incremental.move_to(pos);
+
+			auto change = [&](local_position_t cell, uint8_t cost) {
+				cost_matrix.set(cell.xx, cell.yy, cost);
+				incremental.set(cell, cost);
+			};
+			auto& path = *repaired.path;
+			if (path.size() > 3) {
+				position_t blocked = path[2 + random_engine() % (path.size() - 2)];
+				if (blocked != pos) {
+					change({blocked.xx, blocked.yy}, 0xff);
+				}
+			}
+			for (int ii = 0; ii < 3; ++ii) {
+				local_position_t cell(1 + random_engine() % 48, 1 + random_engine() % 48);
+				if (cell.xx != pos.xx || cell.yy != pos.yy) {
+					change(cell, random_engine() % 2 == 0 ? 0xff : 1);
+				}
+			}
+		}
+	}
+	std::cout <<k_trials <<" trials, " <<steps <<" repaired steps, " <<mismatches <<" cost mismatches\n"
+		<<"repair: " <<(repair_ops / steps) <<" ops per step\n"
+		<<"astar: " <<(search_ops / steps) <<" ops per step\n";
+	return mismatches == 0 ? 0 : 1;
+}
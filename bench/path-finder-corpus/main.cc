@@ -0,0 +1,244 @@
+#include <screeps/cpu.h>
+#include <screeps/memory.h>
+#include <screeps/path-finder.h>
+#include <screeps/terrain.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Native pathfinder benchmark over a recorded corpus. Build with `make path-finder-corpus`.
+//
+//   path-finder-corpus corpus.bin              run every query through each native engine
+//   path-finder-corpus --generate N corpus.bin write a synthetic corpus with N rooms
+//
+// A corpus is a `memory_writer_t` buffer: the room count, then for each room its location,
+// serialized `terrain_t`, and an optional `cost_matrix_t`, then the query count and each query's
+// origin, goals and every option which affects the result (see `corpus_t::serialize`). The
+// JavaScript engine needs `PathFinder` from the game and is skipped.
+//
+// Nothing in the library records queries. A recorded corpus is expected to come from a bot build
+// which wraps its `path_finder_t::search` calls, keeps each query along with the terrain and cost
+// matrix of every room it may enter, and writes them out in this format, for example to a memory
+// segment. `--generate` only makes synthetic corpora.
+using namespace screeps;
+
+constexpr int k_corpus_version = 2;
+
+struct room_record_t {
+	room_location_t location;
+	std::shared_ptr<terrain_t> terrain;
+	std::optional<cost_matrix_t> cost_matrix;
+};
+
+struct query_record_t {
+	position_t origin;
+	path_finder_t::goals_t goals;
+	// `room_callback` and `engine` aren't recorded
+	path_finder_t::options_t options;
+};
+
+struct corpus_t {
+	std::vector<room_record_t> rooms;
+	std::vector<query_record_t> queries;
+
+	template <class Memory>
+	void serialize(Memory& memory) {
+		int32_t count = rooms.size();
+		memory & count;
+		rooms.resize(count);
+		for (auto& room : rooms) {
+			if (!room.terrain) {
+				room.terrain = std::make_shared<terrain_t>();
+			}
+			bool has_matrix = room.cost_matrix.has_value();
+			memory & room.location & *room.terrain & has_matrix;
+			if (has_matrix) {
+				if (!room.cost_matrix) {
+					room.cost_matrix.emplace();
+				}
+				memory & *room.cost_matrix;
+			}
+		}
+		count = queries.size();
+		memory & count;
+		queries.resize(count);
+		for (auto& query : queries) {
+			int32_t goal_count = query.goals.size();
+			memory & query.origin & goal_count;
+			query.goals.resize(goal_count);
+			for (auto& goal : query.goals) {
+				memory & goal.pos & goal.range;
+			}
+			auto& options = query.options;
+			memory & options.plain_cost & options.swamp_cost & options.flee & options.max_ops & options.max_rooms & options.max_cost;
+			// `memory_writer_t` has no floating point serializer
+			memory.copy(reinterpret_cast<uint8_t*>(&options.heuristic_weight), sizeof(options.heuristic_weight));
+		}
+	}
+};
+
+// Terrain can only be inserted into the cache by subclasses or `game_state_t`
+struct corpus_terrain_t : terrain_t {
+	static void insert(room_location_t room, std::shared_ptr<terrain_t> terrain) {
+		terrain_t::insert(room, std::move(terrain));
+	}
+};
+
+corpus_t read_corpus(const std::string& file) {
+	std::ifstream stream(file, std::ios::binary);
+	std::vector<char> bytes(std::istreambuf_iterator<char>(stream), {});
+	memory_reader_t reader(bytes.size());
+	std::memcpy(reader.data(), bytes.data(), bytes.size());
+	if (!reader.reset(bytes.size()) || reader.version() != k_corpus_version) {
+		throw std::runtime_error("Invalid corpus: " + file);
+	}
+	corpus_t corpus;
+	reader & corpus;
+	return corpus;
+}
+
+void write_corpus(const std::string& file, corpus_t& corpus) {
+	memory_writer_t writer(corpus.rooms.size() * 4096 + corpus.queries.size() * 256 + 64, k_corpus_version);
+	writer & corpus;
+	auto view = static_cast<std::string_view>(writer);
+	std::ofstream(file, std::ios::binary).write(view.data(), view.size());
+}
+
+// Random terrain with wall and swamp blobs, a solid border, and exits every 10 tiles
+corpus_t generate_corpus(int room_count) {
+	std::mt19937 random_engine(room_count);
+	corpus_t corpus;
+	int width = std::max(1, static_cast<int>(std::sqrt(room_count)));
+	for (int ii = 0; ii < room_count; ++ii) {
+		room_record_t room;
+		room.location = room_location_t(ii % width, ii / width);
+		room.terrain = std::make_shared<terrain_t>();
+		room.terrain->fill(terrain_t::plain);
+		for (int blob = 0; blob < 40; ++blob) {
+			uint8_t type = blob % 3 == 0 ? terrain_t::swamp : terrain_t::wall;
+			int cx = random_engine() % 50, cy = random_engine() % 50, radius = 1 + random_engine() % 4;
+			for (auto pos : local_position_t(cx, cy).within_range(radius)) {
+				(*room.terrain)[pos] = type;
+			}
+		}
+		for (int jj = 0; jj < 50; ++jj) {
+			uint8_t type = jj % 10 == 5 ? terrain_t::plain : terrain_t::wall;
+			(*room.terrain)[local_position_t(0, jj)] = type;
+			(*room.terrain)[local_position_t(49, jj)] = type;
+			(*room.terrain)[local_position_t(jj, 0)] = type;
+			(*room.terrain)[local_position_t(jj, 49)] = type;
+		}
+		if (ii % 2 == 0) {
+			room.cost_matrix.emplace(0);
+			for (int road = 0; road < 200; ++road) {
+				(*room.cost_matrix)[random_engine() % 2500] = road % 10 == 0 ? 0xff : 1;
+			}
+		}
+		corpus.rooms.push_back(std::move(room));
+	}
+	auto random_position = [&]() {
+		const auto& room = corpus.rooms[random_engine() % corpus.rooms.size()];
+		while (true) {
+			local_position_t pos(1 + random_engine() % 48, 1 + random_engine() % 48);
+			if ((*room.terrain)[pos] != terrain_t::wall) {
+				return position_t(room.location, pos);
+			}
+		}
+	};
+	for (int ii = 0; ii < room_count * 20; ++ii) {
+		query_record_t query{random_position(), {{random_position(), ii % 3}}, {}};
+		query.options.flee = ii % 10 == 0;
+		query.options.max_ops = 20000;
+		query.options.heuristic_weight = ii % 4 == 0 ? 1 : 1.2;
+		if (query.options.flee) {
+			query.goals[0] = {query.origin.in_direction(direction_t::top), 5};
+		}
+		corpus.queries.push_back(std::move(query));
+	}
+	return corpus;
+}
+
+double percentile(std::vector<double>& values, double fraction) {
+	auto nth = values.begin() + std::min<size_t>(values.size() - 1, values.size() * fraction);
+	std::nth_element(values.begin(), nth, values.end());
+	return *nth;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> args(argv + 1, argv + argc);
+	if (args.size() == 3 && args[0] == "--generate") {
+		auto corpus = generate_corpus(std::stoi(args[1]));
+		write_corpus(args[2], corpus);
+		std::cout <<"wrote " <<corpus.rooms.size() <<" rooms and " <<corpus.queries.size() <<" queries to " <<args[2] <<"\n";
+		return 0;
+	} else if (args.size() != 1) {
+		std::cerr <<"usage: path-finder-corpus [--generate rooms] corpus.bin\n";
+		return 1;
+	}
+
+	auto corpus = read_corpus(args[0]);
+	std::unordered_map<room_location_t, const cost_matrix_t*> cost_matrices;
+	for (auto& room : corpus.rooms) {
+		corpus_terrain_t::insert(room.location, room.terrain);
+		cost_matrices[room.location] = room.cost_matrix ? &*room.cost_matrix : nullptr;
+	}
+	auto room_callback = [&](room_location_t room) -> const cost_matrix_t* {
+		static const cost_matrix_t empty(0);
+		auto ii = cost_matrices.find(room);
+		if (ii == cost_matrices.end()) {
+			return nullptr;
+		}
+		return ii->second == nullptr ? &empty : ii->second;
+	};
+	std::cout <<corpus.rooms.size() <<" rooms, " <<corpus.queries.size() <<" queries\n"
+		<<"javascript: skipped, `PathFinder` is only available in game\n";
+
+	std::vector<int32_t> baseline_costs;
+	auto run = [&](const char* name, path_finder_t::engine_t engine) {
+		std::vector<double> latencies;
+		latencies.reserve(corpus.queries.size());
+		int64_t ops = 0;
+		int64_t cost = 0;
+		int incomplete = 0;
+		int mismatches = 0;
+		auto heap = cpu::get_native_heap_statistics();
+		int peak_heap = 0;
+		for (size_t ii = 0; ii < corpus.queries.size(); ++ii) {
+			auto& query = corpus.queries[ii];
+			path_finder_t::options_t options = query.options;
+			options.room_callback = room_callback;
+			options.engine = engine;
+			auto start = std::chrono::steady_clock::now();
+			auto result = path_finder_t::search(query.origin, query.goals, options);
+			latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+			peak_heap = std::max(peak_heap, cpu::get_native_heap_statistics().size - heap.size);
+			ops += result.ops;
+			cost += result.cost;
+			incomplete += result.incomplete;
+			if (baseline_costs.size() < corpus.queries.size()) {
+				baseline_costs.push_back(result.cost);
+			} else if (baseline_costs[ii] != result.cost) {
+				++mismatches;
+			}
+		}
+		auto& after = cpu::get_native_heap_statistics();
+		std::cout <<name <<": " <<ops <<" ops, total cost " <<cost <<", " <<incomplete <<" incomplete, "
+			<<mismatches <<" cost mismatches\n"
+			<<"  latency us: p50 " <<percentile(latencies, 0.5) <<", p90 " <<percentile(latencies, 0.9)
+			<<", p99 " <<percentile(latencies, 0.99) <<", max " <<percentile(latencies, 1) <<"\n"
+			<<"  heap: peak +" <<peak_heap <<" bytes, " <<(after.allocs - heap.allocs) <<" allocs, "
+			<<(after.frees - heap.frees) <<" frees\n";
+	};
+	run("astar", path_finder_t::engine_t::astar);
+	run("jump_point", path_finder_t::engine_t::jump_point);
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include <screeps/game.h>
+#include <screeps/path-finder.h>
+#include <screeps/terrain.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace screeps;
+
+constexpr int k_queries_per_room = 10;
+
+game_state_t game;
+std::mt19937 random_engine;
+
+struct query_t {
+	position_t origin;
+	path_finder_t::goals_t goals;
+};
+
+position_t random_position(room_location_t room, const terrain_t& terrain) {
+	std::uniform_int_distribution<int> distribution(1, 48);
+	while (true) {
+		local_position_t pos(distribution(random_engine), distribution(random_engine));
+		if (terrain[pos] != terrain_t::wall) {
+			return {room, pos};
+		}
+	}
+}
+
+void loop() {
+	game.load();
+
+	// Pick the same random queries for every engine
+	std::vector<query_t> queries;
+	for (auto& [location, room] : game.rooms) {
+		auto terrain = terrain_t::load(location);
+		for (int ii = 0; ii < k_queries_per_room; ++ii) {
+			queries.push_back({random_position(location, *terrain), {{random_position(location, *terrain), 1}}});
+		}
+	}
+	if (queries.empty()) {
+		return;
+	}
+
+	std::vector<int32_t> baseline_costs;
+	auto run = [&](const char* name, path_finder_t::engine_t engine) {
+		path_finder_t::options_t options;
+		options.engine = engine;
+		int ops = 0;
+		int mismatches = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t ii = 0; ii < queries.size(); ++ii) {
+			auto result = path_finder_t::search(queries[ii].origin, queries[ii].goals, options);
+			ops += result.ops;
+			if (baseline_costs.size() < queries.size()) {
+				baseline_costs.push_back(result.cost);
+			} else if (baseline_costs[ii] != result.cost) {
+				++mismatches;
+			}
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout <<name <<": " <<queries.size() <<" searches, " <<ops <<" ops, " <<ms <<"ms, "
+			<<(ops / ms * 1000) <<" ops/sec, " <<mismatches <<" cost mismatches\n";
+	};
+	run("javascript", path_finder_t::engine_t::javascript);
+	run("astar", path_finder_t::engine_t::astar);
+	run("jump_point", path_finder_t::engine_t::jump_point);
+}
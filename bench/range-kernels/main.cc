@@ -0,0 +1,117 @@
+#include <screeps/range-kernels.h>
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Compares `range_kernels` against plain loops over `position_t::range_to`. Build with
+// `make range-kernels`.
+using namespace screeps;
+
+constexpr int k_positions = 4000;
+constexpr int k_targets = 300;
+constexpr int k_iterations = 200;
+
+template <class Function>
+double time_ms(Function function) {
+	auto start = std::chrono::steady_clock::now();
+	for (int ii = 0; ii < k_iterations; ++ii) {
+		function();
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / k_iterations;
+}
+
+int main() {
+	std::mt19937 random_engine(1);
+	auto random_position = [&]() {
+		return position_t(room_location_t(random_engine() % 2, 0), random_engine() % 50, random_engine() % 50);
+	};
+	std::vector<position_t> positions(k_positions);
+	std::vector<position_t> targets(k_targets);
+	for (auto& pos : positions) {
+		pos = random_position();
+	}
+	for (auto& pos : targets) {
+		pos = random_position();
+	}
+	pointer_container_t<const position_t> position_view(positions.data(), positions.data() + positions.size());
+	pointer_container_t<const position_t> target_view(targets.data(), targets.data() + targets.size());
+	std::vector<int32_t> ranges(k_positions);
+	std::vector<int32_t> indices(k_positions);
+	std::vector<uint8_t> mask(k_positions);
+	position_t target = targets[0];
+	int sink = 0;
+	int mismatches = 0;
+
+	auto report = [&](const char* name, double scalar, double bulk) {
+		std::cout <<name <<": scalar " <<scalar <<"ms, bulk " <<bulk <<"ms, " <<(scalar / bulk) <<"x\n";
+	};
+
+	report("range_to", time_ms([&]() {
+		for (int ii = 0; ii < k_positions; ++ii) {
+			ranges[ii] = positions[ii].range_to(target);
+		}
+		sink += ranges[k_positions - 1];
+	}), time_ms([&]() {
+		range_kernels::range_to(position_view, target, {ranges.data(), ranges.data() + ranges.size()});
+		sink += ranges[k_positions - 1];
+	}));
+
+	report("count_within_range", time_ms([&]() {
+		int count = 0;
+		for (auto& pos : positions) {
+			count += pos.range_to(target) <= 5;
+		}
+		sink += count;
+	}), time_ms([&]() {
+		sink += range_kernels::count_within_range(position_view, target, 5);
+	}));
+
+	report("within_range", time_ms([&]() {
+		for (int ii = 0; ii < k_positions; ++ii) {
+			mask[ii] = positions[ii].range_to(target) <= 3;
+		}
+		sink += mask[k_positions - 1];
+	}), time_ms([&]() {
+		sink += range_kernels::within_range(position_view, target, 3, {mask.data(), mask.data() + mask.size()});
+	}));
+
+	report("closest", time_ms([&]() {
+		int best = -1;
+		int best_range = INT_MAX;
+		for (int ii = 0; ii < k_positions; ++ii) {
+			int range = positions[ii].range_to(target);
+			if (range < best_range) {
+				best = ii;
+				best_range = range;
+			}
+		}
+		sink += best;
+	}), time_ms([&]() {
+		sink += range_kernels::closest(position_view, target);
+	}));
+
+	std::vector<int32_t> scalar_indices(k_positions);
+	report("closest_each", time_ms([&]() {
+		for (int ii = 0; ii < k_positions; ++ii) {
+			int best = -1;
+			int best_range = INT_MAX;
+			for (int jj = 0; jj < k_targets; ++jj) {
+				int range = positions[ii].range_to(targets[jj]);
+				if (range < best_range) {
+					best = jj;
+					best_range = range;
+				}
+			}
+			scalar_indices[ii] = best;
+		}
+	}), time_ms([&]() {
+		range_kernels::closest_each(position_view, target_view, {indices.data(), indices.data() + indices.size()}, {ranges.data(), ranges.data() + ranges.size()});
+	}));
+	for (int ii = 0; ii < k_positions; ++ii) {
+		mismatches += indices[ii] != scalar_indices[ii];
+	}
+	std::cout <<mismatches <<" mismatches (" <<sink <<")\n";
+	return mismatches == 0 ? 0 : 1;
+}
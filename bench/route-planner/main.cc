@@ -0,0 +1,112 @@
+#include <screeps/path-finder.h>
+#include <screeps/route-planner.h>
+#include <screeps/terrain.h>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Native benchmark of the hierarchical route planner. Build with `make route-planner`.
+//
+// Builds a `k_width` x `k_width` grid of rooms with 30% walls and 10% swamp, where a quarter of the
+// tiles along each shared edge are exits. Each query goes from the 3 leftmost columns to the 3
+// rightmost, so paths cross 10 or more rooms. Every query is run through each engine directly and
+// through `route_planner_t::search` using that engine for its legs, and the average ops per query
+// are reported. Path costs are compared against direct A* with the default heuristic weight, which
+// isn't always optimal.
+using namespace screeps;
+
+constexpr int k_width = 12;
+constexpr int k_queries = 30;
+
+// Terrain can only be inserted into the cache by subclasses or `game_state_t`
+struct bench_terrain_t : terrain_t {
+	static void insert(room_location_t room, std::shared_ptr<terrain_t> terrain) {
+		terrain_t::insert(room, std::move(terrain));
+	}
+};
+
+struct query_t {
+	position_t origin;
+	path_finder_t::goals_t goals;
+};
+
+void generate_rooms(std::mt19937& random_engine) {
+	// Exits on the edge between two rooms have to match on both sides. `vertical[xx][yy]` is the
+	// edge on the left of room (xx, yy), `horizontal[xx][yy]` the one above it.
+	using edge_t = std::array<bool, 50>;
+	std::vector<std::vector<edge_t>> vertical(k_width + 1, std::vector<edge_t>(k_width));
+	std::vector<std::vector<edge_t>> horizontal(k_width, std::vector<edge_t>(k_width + 1));
+	for (int xx = 0; xx <= k_width; ++xx) {
+		for (int yy = 0; yy < k_width; ++yy) {
+			for (int ii = 0; ii < 50; ++ii) {
+				vertical[xx][yy][ii] = xx > 0 && xx < k_width && ii > 0 && ii < 49 && random_engine() % 4 == 0;
+				horizontal[yy][xx][ii] = xx > 0 && xx < k_width && ii > 0 && ii < 49 && random_engine() % 4 == 0;
+			}
+		}
+	}
+	for (int xx = 0; xx < k_width; ++xx) {
+		for (int yy = 0; yy < k_width; ++yy) {
+			auto terrain = std::make_shared<terrain_t>();
+			for (int ii = 0; ii < 2500; ++ii) {
+				int roll = random_engine() % 10;
+				(*terrain)[ii] = roll < 3 ? terrain_t::wall : (roll < 4 ? terrain_t::swamp : terrain_t::plain);
+			}
+			for (int ii = 0; ii < 50; ++ii) {
+				terrain->set(0, ii, vertical[xx][yy][ii] ? terrain_t::plain : terrain_t::wall);
+				terrain->set(49, ii, vertical[xx + 1][yy][ii] ? terrain_t::plain : terrain_t::wall);
+				terrain->set(ii, 0, horizontal[xx][yy][ii] ? terrain_t::plain : terrain_t::wall);
+				terrain->set(ii, 49, horizontal[xx][yy + 1][ii] ? terrain_t::plain : terrain_t::wall);
+			}
+			bench_terrain_t::insert(room_location_t(xx, yy), terrain);
+		}
+	}
+}
+
+int main() {
+	std::mt19937 random_engine(3);
+	generate_rooms(random_engine);
+	std::vector<query_t> queries;
+	for (int ii = 0; ii < k_queries; ++ii) {
+		position_t origin(room_location_t(random_engine() % 3, random_engine() % k_width), 10 + random_engine() % 30, 10 + random_engine() % 30);
+		position_t goal(room_location_t(k_width - 1 - random_engine() % 3, random_engine() % k_width), 10 + random_engine() % 30, 10 + random_engine() % 30);
+		queries.push_back({origin, {{goal, 1}}});
+	}
+
+	static const cost_matrix_t empty(0);
+	path_finder_t::options_t options;
+	options.max_ops = 200000;
+	options.max_rooms = 64;
+	options.room_callback = [](room_location_t room) -> const cost_matrix_t* {
+		return room.xx >= 0 && room.xx < k_width && room.yy >= 0 && room.yy < k_width ? &empty : nullptr;
+	};
+
+	std::vector<int32_t> astar_costs;
+	auto run = [&](const char* name, path_finder_t::engine_t engine, bool route) {
+		options.engine = engine;
+		int64_t ops = 0;
+		int64_t cost = 0;
+		int64_t extra_cost = 0;
+		int incomplete = 0;
+		for (size_t ii = 0; ii < queries.size(); ++ii) {
+			auto result = route ?
+				route_planner_t::search(queries[ii].origin, queries[ii].goals, options) :
+				path_finder_t::search(queries[ii].origin, queries[ii].goals, options);
+			ops += result.ops;
+			cost += result.cost;
+			incomplete += result.incomplete;
+			if (astar_costs.size() < queries.size()) {
+				astar_costs.push_back(result.cost);
+			} else {
+				extra_cost += result.cost - astar_costs[ii];
+			}
+		}
+		std::cout <<name <<": " <<(ops / queries.size()) <<" ops per query, total cost " <<cost
+			<<" (" <<extra_cost <<" against astar), " <<incomplete <<" incomplete\n";
+	};
+	std::cout <<k_width <<"x" <<k_width <<" rooms, " <<queries.size() <<" queries\n";
+	run("astar", path_finder_t::engine_t::astar, false);
+	run("jump_point", path_finder_t::engine_t::jump_point, false);
+	run("route_planner astar", path_finder_t::engine_t::astar, true);
+	run("route_planner jump_point", path_finder_t::engine_t::jump_point, true);
+	return 0;
+}
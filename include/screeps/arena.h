@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+// Older libc++ (emscripten, Apple) has no std::pmr
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define SCREEPS_HAS_MEMORY_RESOURCE
+#endif
+
+namespace screeps {
+
+// Bump allocator for temporaries which die before the end of the tick. Allocation is a pointer
+// bump, deallocation only reclaims the most recent allocation (which covers vectors growing in
+// place), and everything is released at once by `reset`. Blocks are kept between ticks, and if a
+// tick needed more than one block they're merged so the next tick fits in one.
+//
+// The shared arena from `get()` is reset by `game_state_t::load`, so its memory is valid until the
+// start of the next tick. Use it through `arena_allocator_t`, or as a `std::pmr::memory_resource`
+// where the standard library has one.
+#ifdef SCREEPS_HAS_MEMORY_RESOURCE
+class tick_arena_t : public std::pmr::memory_resource {
+#else
+class tick_arena_t {
+#endif
+	public:
+		static constexpr size_t k_initial_block_size = 64 * 1024;
+
+		tick_arena_t() = default;
+		tick_arena_t(const tick_arena_t&) = delete;
+		tick_arena_t& operator=(const tick_arena_t&) = delete;
+#ifdef SCREEPS_HAS_MEMORY_RESOURCE
+		~tick_arena_t() override;
+#else
+		~tick_arena_t();
+#endif
+
+		static tick_arena_t& get();
+
+		void* allocate_bytes(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+			// A fresh arena has no block, and even an empty request must not return null
+			char* ptr = align(cursor, alignment);
+			if (cursor != nullptr && limit - ptr >= static_cast<ptrdiff_t>(bytes)) {
+				cursor = ptr + bytes;
+				return ptr;
+			}
+			return allocate_block(bytes, alignment);
+		}
+
+		void deallocate_bytes(void* ptr, size_t bytes) noexcept {
+			if (static_cast<char*>(ptr) + bytes == cursor) {
+				cursor = static_cast<char*>(ptr);
+			}
+		}
+
+		// Releases every allocation
+		void reset();
+
+		// Bytes handed out since the last reset, the most handed out in any tick, and bytes reserved
+		size_t size() const;
+		size_t peak() const;
+		size_t capacity() const;
+
+#ifdef SCREEPS_HAS_MEMORY_RESOURCE
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override {
+			return allocate_bytes(bytes, alignment);
+		}
+		void do_deallocate(void* ptr, size_t bytes, size_t /* alignment */) override {
+			deallocate_bytes(ptr, bytes);
+		}
+		bool do_is_equal(const std::pmr::memory_resource& that) const noexcept override {
+			return this == &that;
+		}
+#endif
+
+	private:
+		struct block_t {
+			char* data;
+			size_t size;
+		};
+		std::vector<block_t> blocks;
+		char* cursor = nullptr;
+		char* limit = nullptr;
+		// Bytes used in blocks before the current one
+		size_t retired = 0;
+		size_t high_water = 0;
+
+		static char* align(char* ptr, size_t alignment) {
+			return reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(ptr) + alignment - 1) & ~(alignment - 1));
+		}
+		void* allocate_block(size_t bytes, size_t alignment);
+};
+
+// STL allocator over a `tick_arena_t`, the shared one by default. This avoids the virtual call of
+// `std::pmr::polymorphic_allocator`.
+template <class Type>
+class arena_allocator_t {
+	public:
+		using value_type = Type;
+
+		arena_allocator_t() noexcept : arena(&tick_arena_t::get()) {}
+		explicit arena_allocator_t(tick_arena_t& arena) noexcept : arena(&arena) {}
+		template <class Other>
+		arena_allocator_t(const arena_allocator_t<Other>& that) noexcept : arena(that.arena) {} // NOLINT(hicpp-explicit-conversions)
+
+		Type* allocate(size_t count) {
+			if (count > SIZE_MAX / sizeof(Type)) {
+				throw std::bad_array_new_length();
+			}
+			return static_cast<Type*>(arena->allocate_bytes(count * sizeof(Type), alignof(Type)));
+		}
+
+		void deallocate(Type* ptr, size_t count) noexcept {
+			arena->deallocate_bytes(ptr, count * sizeof(Type));
+		}
+
+		template <class Other>
+		bool operator==(const arena_allocator_t<Other>& that) const noexcept { return arena == that.arena; }
+		template <class Other>
+		bool operator!=(const arena_allocator_t<Other>& that) const noexcept { return arena != that.arena; }
+
+	private:
+		template <class Other>
+		friend class arena_allocator_t;
+		tick_arena_t* arena;
+};
+
+template <class Type>
+using arena_vector_t = std::vector<Type, arena_allocator_t<Type>>;
+
+} // namespace screeps
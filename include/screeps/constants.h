@@ -4,6 +4,7 @@ namespace screeps {
 
 // Constants which affect memory layout and maximum entities
 constexpr int kMaximumPathLength = 1500;
+constexpr int kTerrainCacheSize = 1 << 20; // 1MB, about 1600 rooms
 
 // Screeps constants
 constexpr int kMaxCreepSize = 50;
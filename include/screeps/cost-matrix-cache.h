@@ -0,0 +1,38 @@
+#pragma once
+#include "./path-finder.h"
+#include "./position.h"
+#include <cstdint>
+
+namespace screeps {
+
+class game_state_t;
+
+// Cost matrices built from visible room state, shared by every search in a tick. The base matrix
+// has roads at 1 and impassable structures at 255. Hostile ramparts are impassable, your own
+// construction sites for impassable structures are too so creeps don't stand where you're building,
+// and portals are blocked so paths don't cross them by accident. Layers add creeps and hostile zones
+// on top of the base matrix and are built the first time they're requested each tick.
+//
+// `update` is called by `game_state_t::load`. It rebuilds base matrices for visible rooms; matrices
+// for rooms that are no longer visible keep the structures last seen there.
+class cost_matrix_cache_t {
+	public:
+		enum layer_t {
+			base = 0,
+			// Every creep is impassable
+			creeps = 1 << 0,
+			// Tiles in attack range of hostile creeps cost at least `k_hostile_zone_cost`
+			hostile_zones = 1 << 1,
+		};
+		static constexpr uint8_t k_hostile_zone_cost = 50;
+
+		static void update(const game_state_t& game);
+		// Returns nullptr for rooms which have never been seen
+		static const cost_matrix_t* get(room_location_t room, int layers = base);
+		// Room callback for `path_finder_t::options_t`. Rooms which have never been seen use terrain only.
+		// Matrices returned by `get` or the callback are only valid until the next `update`.
+		static path_finder_t::callback_t callback(int layers = base);
+		static void flush();
+};
+
+} // namespace screeps
@@ -1,13 +1,140 @@
 #pragma once
+#include <array>
 #include <cstddef>
+#include <iosfwd>
 
 namespace screeps::cpu {
 	struct native_heap_t {
 		int allocs = 0;
 		int frees = 0;
 		int size = 0;
+		// Bytes handed out by `tick_arena_t::get()` this tick, and the most in any tick
+		int arena_size = 0;
+		int arena_peak = 0;
+	};
+
+	// Collected by the `malloc` overrides while the profiler is enabled. Size class `ii` holds blocks
+	// whose usable size is at most `1 << ii` bytes, and the last one holds everything larger. Ticks
+	// are started by `game_state_t::load`.
+	struct allocation_profile_t {
+		static constexpr int k_size_classes = 24;
+		static constexpr int k_max_tags = 32;
+
+		struct counts_t {
+			int allocs = 0;
+			int frees = 0;
+			int live_bytes = 0;
+		};
+
+		struct tick_t {
+			// Highest `native_heap_t::size`, and bytes and blocks allocated
+			int peak = 0;
+			int churn = 0;
+			int allocs = 0;
+		};
+
+		// Tag 0 is for allocations made outside any `allocation_tag_t`
+		struct tag_t {
+			const char* name = nullptr;
+			counts_t counts;
+		};
+
+		std::array<counts_t, k_size_classes> size_classes;
+		std::array<tag_t, k_max_tags> tags;
+		int tag_count = 1;
+		tick_t tick;
+		tick_t last_tick;
+	};
+
+	// Attributes allocations made during its lifetime to `name`, which must outlive the profile (use
+	// a string literal). Tags nest, and beyond `k_max_tags` names allocations stay with the enclosing
+	// tag. Does nothing while the profiler is disabled.
+	class allocation_tag_t {
+		public:
+			explicit allocation_tag_t(const char* name);
+			allocation_tag_t(const allocation_tag_t&) = delete;
+			allocation_tag_t& operator=(const allocation_tag_t&) = delete;
+			~allocation_tag_t();
+
+		private:
+			int previous;
+	};
+
+	// Time spent in each `profile_zone_t`, in milliseconds summed over `ticks` ticks. Inclusive
+	// time counts nested zones and exclusive time doesn't. A zone which recurses into itself only
+	// counts inclusive time for the outermost call.
+	struct zone_statistics_t {
+		const char* name = nullptr;
+		int calls = 0;
+		double inclusive = 0;
+		double exclusive = 0;
+	};
+
+	struct cpu_profile_t {
+		static constexpr int k_max_zones = 128;
+		std::array<zone_statistics_t, k_max_zones> zones;
+		int zone_count = 0;
+		int ticks = 0;
+	};
+
+	// Times its own lifetime. Use `SCREEPS_PROFILE_ZONE("name")`, which registers the name once. Does
+	// nothing while the profiler is disabled.
+	class profile_zone_t {
+		public:
+			explicit profile_zone_t(int zone);
+			profile_zone_t(const profile_zone_t&) = delete;
+			profile_zone_t& operator=(const profile_zone_t&) = delete;
+			~profile_zone_t();
+
+			// Returns the zone id for `name`, which must outlive the profile (use a string literal).
+			// Names beyond `k_max_zones` get -1 and aren't timed.
+			static int register_zone(const char* name);
+
+		private:
+			profile_zone_t* parent;
+			double start;
+			double children = 0;
+			int zone;
 	};
 
 	const native_heap_t& get_native_heap_statistics();
 	void halt();
+
+	// `Game.cpu.getUsed()`, `limit`, `tickLimit` and `bucket`. Native builds have no `Game.cpu`, so
+	// these return the values from `set_native_limits` and time since it was last called.
+	double get_used();
+	int get_limit();
+	int get_tick_limit();
+	int get_bucket();
+	void set_native_limits(int limit, int tick_limit, int bucket);
+
+	// The profiler costs a few counter updates on each allocation, plus a hash table lookup for
+	// tagged ones, so it's cheap enough to leave on. Blocks allocated before it was enabled count
+	// as untagged when freed.
+	void enable_allocation_profiler(bool enabled);
+	const allocation_profile_t& get_allocation_profile();
+	void begin_allocation_tick();
+	// Prints to `std::cout`, which goes to the game console
+	void print_allocation_profile();
+	void print_allocation_profile(std::ostream& os);
+
+	// Milliseconds on a monotonic clock. This is `performance.now()` in game, which is much cheaper
+	// than `Game.cpu.getUsed()`.
+	double now();
+
+	// Aggregates zones over `ticks` ticks, then prints the report and starts over. 0 disables.
+	void enable_cpu_profiler(int ticks);
+	const cpu_profile_t& get_cpu_profile();
+	// Called by `game_state_t::load`
+	void begin_cpu_profile_tick();
+	void reset_cpu_profile();
+	// Zones sorted by exclusive time, averaged per tick
+	void print_cpu_profile();
+	void print_cpu_profile(std::ostream& os);
 }; // namespace screeps::cpu
+
+#define SCREEPS_PROFILE_ZONE_CONCAT(left, right) left##right
+#define SCREEPS_PROFILE_ZONE_NAME(left, right) SCREEPS_PROFILE_ZONE_CONCAT(left, right)
+#define SCREEPS_PROFILE_ZONE(name) \
+	static const int SCREEPS_PROFILE_ZONE_NAME(profile_zone_id_, __LINE__) = ::screeps::cpu::profile_zone_t::register_zone(name); \
+	::screeps::cpu::profile_zone_t SCREEPS_PROFILE_ZONE_NAME(profile_zone_, __LINE__)(SCREEPS_PROFILE_ZONE_NAME(profile_zone_id_, __LINE__))
@@ -1,4 +1,5 @@
 #pragma once
+#include "./arena.h"
 #include "./array.h"
 #include "./constants.h"
 #include "./position.h"
@@ -115,6 +116,7 @@ struct creep_t : game_object_t {
 	}
 
 	const std::vector<creep_active_bodypart_t> get_active_bodyparts() const;
+	arena_vector_t<creep_active_bodypart_t> get_active_bodyparts(tick_arena_t& arena) const;
 
 	template <class Memory>
 	void serialize(Memory& memory) {
@@ -0,0 +1,48 @@
+#pragma once
+#include "./path-finder.h"
+#include "./position.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace screeps {
+
+// Direction and distance to the nearest goal from every tile in a room or cluster of rooms. This is
+// built with one Dijkstra search outward from all goals at once, so any number of creeps headed to
+// the same goals can step with an O(1) lookup instead of each running `path_finder_t::search`.
+//
+// `plain_cost`, `swamp_cost` and `room_callback` from `path_finder_t::options_t` are respected. A
+// room whose callback returns nullptr is left out of the field. Other options are ignored.
+class flow_field_t {
+	public:
+		using direction_matrix_t = local_matrix_t<direction_t>;
+		using distance_matrix_t = local_matrix_t<uint16_t>;
+		static constexpr uint16_t k_unreachable = 0xffff;
+
+		struct room_field_t {
+			room_location_t location;
+			direction_matrix_t directions;
+			distance_matrix_t distances;
+		};
+
+		flow_field_t(const path_finder_t::goals_t& goals, const std::vector<room_location_t>& rooms, const path_finder_t::options_t& options = {});
+
+		// Direction to step from `pos`. Empty if `pos` is already in range of a goal or can't reach one.
+		std::optional<direction_t> direction(position_t pos) const;
+		// Total cost to reach the nearest goal from `pos`, or `k_unreachable`
+		int distance(position_t pos) const;
+		const room_field_t* room(room_location_t location) const;
+
+		// Returns a cached field or builds a new one. A cached field is reused until any of the cost
+		// matrices returned by `options.room_callback` change.
+		static std::shared_ptr<const flow_field_t> load(const path_finder_t::goals_t& goals, const std::vector<room_location_t>& rooms, const path_finder_t::options_t& options = {});
+		static void flush();
+
+	private:
+		std::vector<room_field_t> rooms;
+
+		flow_field_t(const path_finder_t::goals_t& goals, const std::vector<room_location_t>& rooms, const std::vector<const cost_matrix_t*>& cost_matrices, const path_finder_t::options_t& options);
+};
+
+} // namespace screeps
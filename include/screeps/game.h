@@ -69,29 +69,6 @@ class game_state_t {
 				}
 		};
 
-		template <class Identifier, class Base, class Type, Identifier Base::*Property, auto room_t::*Vector>
-		class room_index_t: public index_t<Identifier, Base, Type, Property> {
-			private:
-				template <class Rooms>
-				void ensure_index(Rooms& rooms) {
-					if (!this->did_index) {
-						this->did_index = true;
-						for (auto& [location, room] : rooms) {
-							for (auto& element : room.*Vector) {
-								this->index.emplace(static_cast<const Base&>(element).*Property, const_cast<Type*>(&element));
-							}
-						}
-					}
-				}
-
-			public:
-				template <class Rooms>
-				Type* find(Rooms& rooms, const Identifier& id) {
-					ensure_index(rooms);
-					return this->find_in_map(id);
-				}
-		};
-
 		// Room pointers for JS
 		container_t<room_t*> room_pointers;
 		internal::memory_range_t<room_t*> room_pointers_memory;
@@ -100,17 +77,22 @@ class game_state_t {
 
 		// Memory ranges for JS
 		internal::memory_range_t<construction_site_t> construction_sites_memory;
+		internal::memory_range_t<creep_t> creeps_memory;
+		internal::memory_range_t<dropped_resource_t> dropped_resources_memory;
 		internal::memory_range_t<flag_t> flags_memory;
+		internal::memory_range_t<source_t> sources_memory;
+		internal::memory_range_t<structure_union_t> structures_memory;
+		internal::memory_range_t<tombstone_t> tombstones_memory;
 
 		// Indices for `_by_id` functions
 		mutable vector_index_t<sid_t, game_object_t, construction_site_t, &construction_site_t::id> construction_sites_by_id;
-		mutable room_index_t<sid_t, game_object_t, creep_t, &creep_t::id, &room_t::creeps> creeps_by_id;
-		mutable room_index_t<creep_t::name_t, creep_t, creep_t, &creep_t::name, &room_t::creeps> creeps_by_name;
-		mutable room_index_t<sid_t, game_object_t, dropped_resource_t, &dropped_resource_t::id, &room_t::dropped_resources> dropped_resources_by_id;
+		mutable vector_index_t<sid_t, game_object_t, creep_t, &creep_t::id> creeps_by_id;
+		mutable vector_index_t<creep_t::name_t, creep_t, creep_t, &creep_t::name> creeps_by_name;
+		mutable vector_index_t<sid_t, game_object_t, dropped_resource_t, &dropped_resource_t::id> dropped_resources_by_id;
 		mutable vector_index_t<flag_t::name_t, flag_t, flag_t, &flag_t::name> flags_by_name;
-		mutable room_index_t<sid_t, game_object_t, source_t, &source_t::id, &room_t::sources> sources_by_id;
-		mutable room_index_t<sid_t, game_object_t, structure_union_t, &structure_t::id, &room_t::structures> structures_by_id;
-		mutable room_index_t<sid_t, game_object_t, tombstone_t, &tombstone_t::id, &room_t::tombstones> tombstones_by_id;
+		mutable vector_index_t<sid_t, game_object_t, source_t, &source_t::id> sources_by_id;
+		mutable vector_index_t<sid_t, game_object_t, structure_union_t, &structure_t::id> structures_by_id;
+		mutable vector_index_t<sid_t, game_object_t, tombstone_t, &tombstone_t::id> tombstones_by_id;
 
 	public:
 		int32_t gcl;
@@ -118,20 +100,31 @@ class game_state_t {
 
 		std::unordered_map<room_location_t, room_t> rooms;
 
+		// Every visible room's objects, grouped by room. `room_t` containers are views into these.
 		container_t<construction_site_t> construction_sites;
+		container_t<creep_t> creeps;
+		container_t<dropped_resource_t> dropped_resources;
 		container_t<flag_t> flags;
+		container_t<source_t> sources;
+		container_t<structure_union_t> structures;
+		container_t<tombstone_t> tombstones;
 
 		raw_memory_t memory;
 
 	public:
 		static void init_layout();
 		static void ensure_capacity(game_state_t* game);
+		static void allocate_rooms(game_state_t* game);
 
 	private:
 		void clear_indices();
 		void update_pointers();
 		template <auto Property, class Container>
 		void update_pointer_container(Container& container);
+		template <class Type>
+		void allocate_room_objects(container_t<Type>& container, internal::memory_range_t<Type>& memory, internal::memory_range_t<Type> room_t::*range);
+		template <class Type>
+		void compact_room_objects(container_t<Type>& container, internal::memory_range_t<Type>& memory, internal::memory_range_t<Type> room_t::*range);
 		void write_room_pointers();
 
 	public:
@@ -139,6 +132,7 @@ class game_state_t {
 		void serialize(Memory& memory) {
 			memory & gcl & time;
 			memory & construction_sites;
+			memory & creeps & dropped_resources & sources & structures & tombstones;
 			memory & rooms;
 
 			// Super hacky terrain storage
@@ -170,24 +164,24 @@ class game_state_t {
 		}
 
 		creep_t* creep_by_id(const sid_t& id) {
-			return creeps_by_id.find(rooms, id);
+			return creeps_by_id.find(creeps, id);
 		}
 		const creep_t* creep_by_id(const sid_t& id) const {
-			return creeps_by_id.find(rooms, id);
+			return creeps_by_id.find(creeps, id);
 		}
 
 		creep_t* creep_by_name(const creep_t::name_t& name) {
-			return creeps_by_name.find(rooms, name);
+			return creeps_by_name.find(creeps, name);
 		}
 		const creep_t* creep_by_name(const creep_t::name_t& name) const {
-			return creeps_by_name.find(rooms, name);
+			return creeps_by_name.find(creeps, name);
 		}
 
 		dropped_resource_t* dropped_resource_by_id(const sid_t& id) {
-			return dropped_resources_by_id.find(rooms, id);
+			return dropped_resources_by_id.find(dropped_resources, id);
 		}
 		const dropped_resource_t* dropped_resource_by_id(const sid_t& id) const {
-			return dropped_resources_by_id.find(rooms, id);
+			return dropped_resources_by_id.find(dropped_resources, id);
 		}
 
 		flag_t* flag_by_name(const flag_t::name_t& name) {
@@ -198,17 +192,17 @@ class game_state_t {
 		}
 
 		source_t* source_by_id(const sid_t& id) {
-			return sources_by_id.find(rooms, id);
+			return sources_by_id.find(sources, id);
 		}
 		const source_t* source_by_id(const sid_t& id) const {
-			return sources_by_id.find(rooms, id);
+			return sources_by_id.find(sources, id);
 		}
 
 		structure_union_t* structure_by_id(const sid_t& id) {
-			return structures_by_id.find(rooms, id);
+			return structures_by_id.find(structures, id);
 		}
 		const structure_union_t* structure_by_id(const sid_t& id) const {
-			return structures_by_id.find(rooms, id);
+			return structures_by_id.find(structures, id);
 		}
 };
 
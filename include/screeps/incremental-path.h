@@ -0,0 +1,80 @@
+#pragma once
+#include "./path-finder.h"
+#include "./position.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace screeps {
+
+class terrain_t;
+
+// Path within one room which is kept up to date as the creep moves and its cost matrix changes,
+// using D* Lite. The search runs backward from the goals, so when a few cells change only the
+// part of the search affected by those cells is redone instead of searching from scratch.
+//
+// Goals outside the origin's room are ignored. `plain_cost`, `swamp_cost` and `max_ops` from
+// `options_t` are used; `max_ops` bounds the work done per call, and a search which runs out
+// continues on the next call.
+class incremental_path_t {
+	public:
+		incremental_path_t(position_t origin, const path_finder_t::goals_t& goals, const cost_matrix_t& cost_matrix, const path_finder_t::options_t& options = {});
+
+		// Call after the creep moves
+		void move_to(position_t pos);
+		// Replaces the cost matrix. Only cells which differ from the previous matrix are repaired.
+		void update(const cost_matrix_t& cost_matrix);
+		void set(local_position_t pos, uint8_t cost);
+
+		// Next step from the current position, or empty if the creep is at a goal or can't reach one
+		std::optional<direction_t> next_direction();
+		path_finder_t::result_t path();
+
+		// Ops used by the last repair, and by all repairs since construction
+		int last_ops() const { return ops; }
+		int total_ops() const { return total; }
+
+	private:
+		using key_t = std::pair<uint32_t, uint32_t>;
+		struct open_t {
+			key_t key;
+			int index;
+
+			// Inverted because `std::push_heap` builds a max-heap
+			bool operator<(const open_t& rhs) const {
+				return key > rhs.key;
+			}
+		};
+
+		room_location_t room;
+		int start;
+		int last_start;
+		uint32_t key_modifier = 0;
+		uint32_t min_cost;
+		int max_ops;
+		int ops = 0;
+		int total = 0;
+		std::shared_ptr<terrain_t> terrain;
+		path_finder_t::options_t options;
+		cost_matrix_t cost_matrix;
+		local_matrix_t<bool> goals;
+		std::vector<uint32_t> g;
+		std::vector<uint32_t> rhs;
+		std::vector<key_t> queued_keys;
+		std::vector<bool> queued;
+		std::vector<open_t> open_list;
+
+		uint32_t cost(int index) const;
+		uint32_t heuristic(int index) const;
+		key_t calculate_key(int index) const;
+		void push(int index);
+		bool top(open_t& entry);
+		void update_vertex(int index);
+		void update_neighbors(int index);
+		bool compute_shortest_path();
+		std::optional<int> next_index();
+};
+
+} // namespace screeps
@@ -0,0 +1,113 @@
+#pragma once
+#include "./creep.h"
+#include "./position.h"
+#include "./resource.h"
+#include "./structure.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace screeps {
+
+// Batched alternative to the action methods on `creep_t`, `spawn_t` and `room_t`. Actions are
+// recorded as fixed-size binary records and submitted to the game in a single JS call by `flush`,
+// instead of crossing into JS and looking up objects by id once per action. Anything still queued
+// when `loop()` returns is flushed automatically.
+//
+// Return codes come back through the optional callback, which runs during `flush`, or through
+// `result`. Callbacks may queue more intents, which go out with the next flush. An action whose
+// object no longer exists returns `k_err_invalid_target` instead of throwing.
+class intent_queue_t {
+	friend class game_state_t;
+	public:
+		// nb: must match `kinds` in intent.js
+		enum struct kind_t : uint8_t {
+			build,
+			drop,
+			harvest,
+			move,
+			pickup,
+			repair,
+			suicide,
+			transfer,
+			upgrade_controller,
+			withdraw,
+			spawn_creep,
+			create_construction_site,
+		};
+
+		// Identifies an intent queued this tick
+		struct intent_t {
+			int generation;
+			int index;
+		};
+
+		using callback_t = std::function<void(int)>;
+
+		intent_queue_t() = default;
+		intent_queue_t(const intent_queue_t&) = delete;
+		intent_queue_t& operator=(const intent_queue_t&) = delete;
+
+		static intent_queue_t& get();
+
+		intent_t build(const creep_t& creep, const game_object_t& target, callback_t callback = nullptr);
+		intent_t drop(const creep_t& creep, resource_t resource, int amount = -1, callback_t callback = nullptr);
+		intent_t harvest(const creep_t& creep, const game_object_t& target, callback_t callback = nullptr);
+		intent_t move(const creep_t& creep, direction_t direction, callback_t callback = nullptr);
+		intent_t pickup(const creep_t& creep, const game_object_t& target, callback_t callback = nullptr);
+		intent_t repair(const creep_t& creep, const game_object_t& target, callback_t callback = nullptr);
+		intent_t suicide(const creep_t& creep, callback_t callback = nullptr);
+		intent_t transfer(const creep_t& creep, const game_object_t& target, resource_t resource, int amount = -1, callback_t callback = nullptr);
+		intent_t upgrade_controller(const creep_t& creep, const game_object_t& target, callback_t callback = nullptr);
+		intent_t withdraw(const creep_t& creep, const game_object_t& target, resource_t resource, int amount = -1, callback_t callback = nullptr);
+		intent_t spawn_creep(const spawn_t& spawn, const spawn_t::body_t& body, const std::string& name, const spawn_t::options_t& options = {}, callback_t callback = nullptr);
+		intent_t create_construction_site(position_t pos, structure_t::type_t structure_type, const std::string& name = "", callback_t callback = nullptr);
+
+		// Submits every queued intent, fills in their results, and then invokes their callbacks
+		void flush();
+		// Flushes the queue after `loop()` returns. Called by main.js.
+		static void flush_tick();
+
+		// The intent's return code, flushing first if it hasn't been submitted yet. Throws if the
+		// intent is from an earlier tick.
+		int result(intent_t intent);
+
+		// Intents queued this tick, and how many of them haven't been submitted
+		size_t size() const { return records.size(); }
+		size_t pending() const { return records.size() - flushed; }
+
+	private:
+		struct record_t {
+			sid_t object;
+			sid_t target;
+			int32_t result;
+			// Direction, resource, structure type, or body handle
+			int32_t argument;
+			// Amount or spawn directions
+			int32_t amount;
+			uint32_t name;
+			uint32_t name_length;
+			position_t pos;
+			kind_t kind;
+		};
+
+		std::vector<record_t> records;
+		std::vector<std::pair<int, callback_t>> callbacks;
+		// Bodies stay referenced until they're submitted
+		std::vector<spawn_t::body_t> bodies;
+		std::string names;
+		size_t flushed = 0;
+		size_t next_callback = 0;
+		int generation = 0;
+
+		static void init();
+		void reset();
+		record_t& push(kind_t kind, const sid_t& object, callback_t& callback);
+		void push_name(record_t& record, const std::string& name);
+		intent_t last() const {
+			return {generation, static_cast<int>(records.size()) - 1};
+		}
+};
+
+} // namespace screeps
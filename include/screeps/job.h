@@ -0,0 +1,100 @@
+#pragma once
+#include "./memory.h"
+#include "./scheduler.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace screeps {
+
+// A computation spread over many ticks. `step` does one slice of work and returns true once the
+// job is finished. Between slices the job's whole state must be serializable, since a global
+// reset can happen at any tick boundary.
+class job_t {
+	public:
+		virtual ~job_t() = default;
+		virtual bool step() = 0;
+		virtual void write(memory_writer_t& writer) = 0;
+		virtual void read(memory_reader_t& reader) = 0;
+};
+
+// Adapts a `State` with `bool step()` and `template <class Memory> void serialize(Memory& memory)`
+template <class State>
+class state_job_t : public job_t {
+	public:
+		explicit state_job_t(State state = State{}) : state(std::move(state)) {}
+
+		bool step() override { return state.step(); }
+		void write(memory_writer_t& writer) override { writer & state; }
+		void read(memory_reader_t& reader) override { reader & state; }
+
+		State state;
+};
+
+// Runs jobs through a `cpu::scheduler_t` and checkpoints all of them into one memory segment, so that
+// after a global reset `restore` picks up from the last checkpoint. Call `checkpoint` after `run`
+// every tick and no slice is ever lost.
+//
+// Jobs are recreated by kind, so each state type is registered under a number which must stay the
+// same across code updates. Changing a state's serialized layout needs a new kind.
+class job_queue_t {
+	public:
+		static constexpr int k_version = 1;
+		// Segments are stored two bytes per character
+		static constexpr size_t k_checkpoint_size = k_memory_segment_size * 2;
+
+		explicit job_queue_t(int segment, const cpu::scheduler_t::options_t& options = {}) : scheduler(options), segment(segment) {}
+		// Scheduler tasks point back to the queue
+		job_queue_t(const job_queue_t&) = delete;
+		job_queue_t& operator=(const job_queue_t&) = delete;
+
+		template <class State>
+		void register_kind(uint16_t kind) {
+			factories[kind] = []() -> std::unique_ptr<job_t> {
+				return std::make_unique<state_job_t<State>>();
+			};
+		}
+
+		// Returns an id for `cancel`. `State`'s kind must be registered.
+		template <class State>
+		int start(uint16_t kind, int priority, State state) {
+			return add(next_id++, kind, priority, std::make_unique<state_job_t<State>>(std::move(state)));
+		}
+		bool cancel(int id);
+		size_t size() const { return entries.size(); }
+
+		// Recreates jobs from the checkpoint segment, which must be active this tick. Returns false and
+		// leaves the queue empty if there's no checkpoint or it can't be read.
+		bool restore(const raw_memory_t& memory);
+		// Runs this tick's slices within the CPU budget
+		void run() { scheduler.run(); }
+		// Returns false if the segment can't be saved this tick or the jobs don't fit
+		bool checkpoint(const raw_memory_t& memory);
+
+		// Checkpoint format, for `restore` and `checkpoint`
+		void write(memory_writer_t& writer);
+		bool read(memory_reader_t& reader);
+
+		const cpu::scheduler_t::statistics_t& get_statistics() const { return scheduler.get_statistics(); }
+
+	private:
+		struct entry_t {
+			int id;
+			int task;
+			int priority;
+			uint16_t kind;
+			std::unique_ptr<job_t> job;
+		};
+		std::unordered_map<uint16_t, std::function<std::unique_ptr<job_t>()>> factories;
+		std::vector<entry_t> entries;
+		cpu::scheduler_t scheduler;
+		int segment;
+		int next_id = 0;
+
+		int add(int id, uint16_t kind, int priority, std::unique_ptr<job_t> job);
+		void clear();
+};
+
+} // namespace screeps
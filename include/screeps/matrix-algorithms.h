@@ -0,0 +1,86 @@
+#pragma once
+#include "./position.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Searches and transforms over `local_matrix_t`. These work on the flat `xx * 50 + yy` index with
+// `local_neighbor_table` precomputed as index offsets, so the inner loops never build a
+// `local_position_t` or check bounds. Neighbors are the 8 surrounding tiles in the same room.
+namespace screeps::matrix_algorithms {
+
+using distance_matrix_t = local_matrix_t<uint8_t>;
+using label_matrix_t = local_matrix_t<uint16_t>;
+static constexpr uint8_t k_unreachable = 0xff;
+
+enum struct metric_t { chebyshev, manhattan };
+
+// `detail::local_neighbor_table` as offsets of the flat index, indexed by `detail::edge_class`
+struct neighbor_offsets_t {
+	std::array<int16_t, 8> offsets;
+	int count;
+};
+
+inline const std::array<neighbor_offsets_t, 9> neighbor_offset_table = [] {
+	std::array<neighbor_offsets_t, 9> table{};
+	local_position_t center(25, 25);
+	for (int kind = 0; kind < 9; ++kind) {
+		auto [begin, end] = detail::local_neighbor_table[kind];
+		for (auto ii = begin; ii != end; ++ii) {
+			local_position_t neighbor = center.in_direction(*ii);
+			table[kind].offsets[table[kind].count++] = (neighbor.xx - center.xx) * 50 + neighbor.yy - center.yy;
+		}
+	}
+	return table;
+}();
+
+// Invokes `function(int index)` for each neighbor of `index`
+template <class Function>
+void for_each_neighbor(int index, Function function) {
+	const auto& neighbors = neighbor_offset_table[detail::edge_class(index)];
+	for (int ii = 0; ii < neighbors.count; ++ii) {
+		function(index + neighbors.offsets[ii]);
+	}
+}
+
+// Number of steps from the nearest source through `passable` tiles, or `k_unreachable`. Sources
+// are expanded even if they aren't passable. Distances stop at `max_distance`, which must be less
+// than `k_unreachable`.
+distance_matrix_t bfs_distance(const std::vector<local_position_t>& sources, const local_matrix_t<bool>& passable, int max_distance = k_unreachable - 1);
+
+// Marks every tile reachable from `origin` through tiles where `predicate(int index)` is true and
+// returns how many were marked. Nothing is marked if `origin` fails the predicate.
+template <class Predicate>
+int flood_fill(local_position_t origin, Predicate predicate, local_matrix_t<bool>& filled) {
+	filled.fill(false);
+	int start = origin.xx * 50 + origin.yy;
+	if (!predicate(start)) {
+		return 0;
+	}
+	std::array<uint16_t, 2500> stack;
+	int size = 0;
+	int count = 1;
+	filled[start] = true;
+	stack[size++] = start;
+	while (size != 0) {
+		int index = stack[--size];
+		for_each_neighbor(index, [&](int next) {
+			if (!filled[next] && predicate(next)) {
+				filled[next] = true;
+				stack[size++] = next;
+				++count;
+			}
+		});
+	}
+	return count;
+}
+
+// Labels each 8-connected group of set tiles in `mask` with 1, 2, .. in index order of the group's
+// first tile, and clear tiles with 0. Returns the number of groups.
+int connected_components(const local_matrix_t<bool>& mask, label_matrix_t& labels);
+
+// Distance from each set tile in `mask` to the nearest clear tile, with two chamfer passes. Clear
+// tiles are 0 and tiles outside the room count as clear, so set tiles on the edge are 1.
+distance_matrix_t distance_transform(const local_matrix_t<bool>& mask, metric_t metric = metric_t::chebyshev);
+
+} // namespace screeps::matrix_algorithms
@@ -0,0 +1,74 @@
+#pragma once
+#include "./path-finder.h"
+#include "./position.h"
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace screeps {
+
+// Remembers the results of `path_finder_t::search` so repeated searches, like a hauler walking the
+// same route every trip, don't have to run again. A search starting anywhere along a cached path to
+// the same goals with the same options reuses the rest of that path.
+//
+// `room_callback` can't be compared, so each cache should be used with one callback. Call
+// `invalidate` after changing the cost matrix of a room and only paths through that room will be
+// dropped. Incomplete results are never cached.
+class path_cache_t {
+	public:
+		struct statistics_t {
+			int hits = 0;
+			int partial_hits = 0;
+			int misses = 0;
+			int invalidations = 0;
+			int evictions = 0;
+			int size = 0;
+
+			double hit_rate() const {
+				int total = hits + partial_hits + misses;
+				return total == 0 ? 0 : static_cast<double>(hits + partial_hits) / total;
+			}
+		};
+
+		explicit path_cache_t(int capacity = 256) : capacity(capacity) {}
+
+		// Returns a cached path if one exists, otherwise runs `path_finder_t::search` and saves the
+		// result. `ops` is 0 when the path came from the cache.
+		path_finder_t::result_t search(position_t origin, const path_finder_t::goals_t& goals, const path_finder_t::options_t& options);
+		void invalidate(room_location_t room);
+		void clear();
+		const statistics_t& get_statistics() const { return statistics; }
+
+	private:
+		// Path stored as an origin and one 4-bit direction per step, along with the cost of entering
+		// each tile so the cost of any suffix can be reported.
+		struct entry_t {
+			path_finder_t::goals_t goals;
+			size_t options_hash;
+			position_t origin;
+			uint32_t length;
+			std::vector<uint8_t> directions;
+			std::vector<uint8_t> costs;
+			std::vector<std::pair<room_location_t, uint32_t>> versions;
+
+			direction_t direction(uint32_t step) const {
+				return static_cast<direction_t>((directions[step >> 1] >> ((step & 1) << 2)) & 0x0f);
+			}
+		};
+		using entry_iterator_t = std::list<entry_t>::iterator;
+
+		int capacity;
+		statistics_t statistics;
+		// Most recently used entry is at the front
+		std::list<entry_t> entries;
+		// Every position on every cached path, pointing to the number of steps already taken
+		std::unordered_multimap<position_t, std::pair<entry_iterator_t, uint32_t>> positions;
+		std::unordered_map<room_location_t, uint32_t> room_versions;
+
+		bool is_stale(const entry_t& entry) const;
+		void insert(position_t origin, const path_finder_t::goals_t& goals, const path_finder_t::options_t& options, size_t options_hash, const path_finder_t::result_t& result);
+		void erase(entry_iterator_t entry);
+};
+
+} // namespace screeps
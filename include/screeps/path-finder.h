@@ -1,6 +1,7 @@
 #pragma once
 #include "./array.h"
 #include "./constants.h"
+#include "./iterator.h"
 #include "./position.h"
 #include <functional>
 #include <memory>
@@ -15,6 +16,11 @@ struct path_finder_t {
 	using path_ptr_t = std::unique_ptr<path_t>;
 	using callback_t = std::function<const cost_matrix_t*(room_location_t)>;
 
+	// `javascript` is the game's own `PathFinder.search`. `astar` and `jump_point` run in C++ directly
+	// on `terrain_t` and `cost_matrix_t`. `jump_point` skips over runs of tiles with uniform cost and
+	// uses far fewer ops in open areas.
+	enum struct engine_t { javascript, astar, jump_point };
+
 	struct options_t {
 		int plain_cost = 1;
 		int swamp_cost = 5;
@@ -24,6 +30,7 @@ struct path_finder_t {
 		int max_cost = 0x7fffffff;
 		double heuristic_weight = 1.2;
 		callback_t room_callback = nullptr;
+		engine_t engine = engine_t::javascript;
 	};
 
 	struct result_t {
@@ -39,8 +46,29 @@ struct path_finder_t {
 	};
 	using goals_t = std::vector<goal_t>;
 
+	// One search for `search_many`. `path` is set to a range inside the arena passed to `search_many`.
+	struct query_t {
+		position_t origin;
+		goals_t goals;
+		pointer_container_t<position_t> path;
+		int32_t ops = 0;
+		int32_t cost = 0;
+		bool incomplete = true;
+	};
+	using arena_t = pointer_container_t<position_t>;
+
 	static result_t search(position_t origin, const goals_t& goals, const options_t& options);
+	static result_t search_native(position_t origin, const goals_t& goals, const options_t& options);
+	// Runs many searches with the same options. With the JavaScript engine every query runs in one
+	// call, and with any engine `room_callback` is called at most once per room for the whole batch.
+	// Paths are written back to back into `arena`. A query whose path doesn't fit gets an empty path
+	// and is marked incomplete.
+	static void search_many(pointer_container_t<query_t> queries, arena_t arena, const options_t& options);
 	static const void* callback_trampoline(void* fn, int xx, int yy);
+
+	private:
+		// Native search for `search_many`, writing the path to the start of `arena`
+		static void search_native(query_t& query, arena_t arena, const options_t& options);
 };
 
 } // namespace screeps
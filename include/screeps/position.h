@@ -1,8 +1,10 @@
 #pragma once
 #include "./constants.h"
 #include "./iterator.h"
+#include <algorithm>
 #include <climits>
 #include <array>
+#include <cstdint>
 #include <iosfwd>
 #include <limits>
 #include <string_view>
@@ -99,7 +101,10 @@ struct alignas(int32_t) position_t {
 	constexpr int range_to(position_t that) const;
 	constexpr int range_to_edge() const;
 
+	// Neighbors in the same room
 	constexpr auto neighbors() const;
+	// Tiles a creep here can step to, which may be in another room. On an exit tile that's only back
+	// into the room or across the exit, e.g. 4 neighbors at (0, 1) instead of 8.
 	constexpr auto world_neighbors() const;
 	template <class... Types> constexpr auto within_range(int range, Types&&... others) const;
 
@@ -428,10 +433,45 @@ class area_iterable_t {
 		constexpr iterator begin() const { return {offset, width, index}; }
 		constexpr iterator end() const { return {offset, width, final_index}; }
 
+		// Invokes `function(int index)` with the room-local `xx * 50 + yy` index of each position. This
+		// walks column by column, which is contiguous in `local_matrix_t`, so the order differs from
+		// iteration order.
+		template <class Function>
+		constexpr void for_each_index(Function function) const {
+			int height = (final_index - index) / width;
+			int column = offset % 50 * 50 + index / width % 50;
+			for (int last = column + width * 50; column < last; column += 50) {
+				for (int ii = column; ii < column + height; ++ii) {
+					function(ii);
+				}
+			}
+		}
+
 	private:
 		unsigned offset, width, index, final_index;
 };
 
+// Index into `local_neighbor_table` and `world_neighbor_table`: 0 for the low edge, 1 for the high
+// edge, and 2 for neither, for `xx` then `yy`. Coordinates are taken modulo 50 so this also works
+// for `world_position_t`.
+inline constexpr auto k_edge_kinds = [] {
+	std::array<uint8_t, 50> kinds{};
+	for (int ii = 0; ii < 50; ++ii) {
+		kinds[ii] = ii == 0 ? 0 : (ii == 49 ? 1 : 2);
+	}
+	return kinds;
+}();
+
+template <class Holder>
+constexpr int edge_class(Holder origin) {
+	return k_edge_kinds[origin.xx % 50] * 3 + k_edge_kinds[origin.yy % 50];
+}
+
+// Same, for a room-local `xx * 50 + yy` index
+constexpr int edge_class(int index) {
+	return k_edge_kinds[index / 50] * 3 + k_edge_kinds[index % 50];
+}
+
 // Iterates all neighbors from an origin.
 template <class Position, class Holder = Position>
 class neighbor_iterable_t {
@@ -458,73 +498,11 @@ class neighbor_iterable_t {
 
 	public:
 		static constexpr neighbor_iterable_t local_neighbors(Holder origin) {
-			if (origin.xx == 0) {
-				if (origin.yy == 0) {
-					// Top left corner
-					return {origin, local_neighbor_table[0]};
-				} else if (origin.yy == 49) {
-					// Bottom left corner
-					return {origin, local_neighbor_table[1]};
-				} else {
-					// Left side
-					return {origin, local_neighbor_table[2]};
-				}
-			} else if (origin.xx == 49) {
-				if (origin.yy == 0) {
-					// Top right corner
-					return {origin, local_neighbor_table[3]};
-				} else if (origin.yy == 49) {
-					// Bottom right corner
-					return {origin, local_neighbor_table[4]};
-				} else {
-					// Right side
-					return {origin, local_neighbor_table[5]};
-				}
-			} else if (origin.yy == 0) {
-				// Top side
-				return {origin, local_neighbor_table[6]};
-			} else if (origin.yy == 49) {
-				// Bottom side
-				return {origin, local_neighbor_table[7]};
-			} else {
-				// Non-border
-				return {origin, local_neighbor_table[8]};
-			}
+			return {origin, local_neighbor_table[edge_class(origin)]};
 		}
 
 		static constexpr neighbor_iterable_t world_neighbors(Holder origin) {
-			if (origin.xx == 0) {
-				if (origin.yy == 0) {
-					// Top left corner
-					return {origin, world_neighbor_table[0]};
-				} else if (origin.yy == 49) {
-					// Bottom left corner
-					return {origin, world_neighbor_table[1]};
-				} else {
-					// Left side
-					return {origin, world_neighbor_table[2]};
-				}
-			} else if (origin.xx == 49) {
-				if (origin.yy == 0) {
-					// Top right corner
-					return {origin, world_neighbor_table[3]};
-				} else if (origin.yy == 49) {
-					// Bottom right corner
-					return {origin, world_neighbor_table[4]};
-				} else {
-					// Right side
-					return {origin, world_neighbor_table[5]};
-				}
-			} else if (origin.yy == 0) {
-				// Top side
-				return {origin, world_neighbor_table[6]};
-			} else if (origin.yy == 49) {
-				// Bottom side
-				return {origin, world_neighbor_table[7]};
-			} else {
-				// Non-border
-				return {origin, world_neighbor_table[8]};
-			}
+			return {origin, world_neighbor_table[edge_class(origin)]};
 		}
 
 		constexpr iterator begin() const { return {origin, _begin}; }
@@ -540,6 +518,40 @@ class neighbor_iterable_t {
 		const direction_t* _end;
 };
 
+// Offset of index `ii` around the ring of positions at `range` used by `with_range_iterable_t`
+constexpr int ring_offset(int range, int ii) {
+	return std::clamp(range * 2 - detail::abs(ii % (range * 8) - range * 4), -range, range);
+}
+
+// Precomputed `with_range_iterable_t` offsets for ranges up to `k_ring_table_max_range`. Each range
+// has `range * 12` entries covering the ring one and a half times, so that every edge-clipped
+// iteration is a contiguous slice. `delta` is the offset of the flattened `xx * 50 + yy` index.
+struct ring_offset_t {
+	int8_t dx, dy;
+	int16_t delta;
+};
+
+inline constexpr int k_ring_table_max_range = 10;
+
+struct ring_table_t {
+	std::array<int, k_ring_table_max_range + 1> start{};
+	std::array<ring_offset_t, k_ring_table_max_range * (k_ring_table_max_range + 1) * 6> offsets{};
+};
+
+inline constexpr ring_table_t k_ring_table = [] {
+	ring_table_t table;
+	int size = 0;
+	for (int range = 1; range <= k_ring_table_max_range; ++range) {
+		table.start[range] = size;
+		for (int ii = 0; ii < range * 12; ++ii) {
+			int dx = ring_offset(range, ii + range);
+			int dy = ring_offset(range, ii - range);
+			table.offsets[size++] = {static_cast<int8_t>(dx), static_cast<int8_t>(dy), static_cast<int16_t>(dx * 50 + dy)};
+		}
+	}
+	return table;
+}();
+
 // Iterates over all positions that have range equal to a constant. Bounds checking is done once at
 // construction and after that iteration is very simple.
 template <class Position>
@@ -555,9 +567,13 @@ class with_range_iterable_t {
 				constexpr iterator(Position origin, int range, int index) : origin(origin), range(range), index(index) {}
 
 				constexpr reference operator*() const {
+					if (range <= k_ring_table_max_range) {
+						const ring_offset_t& offset = k_ring_table.offsets[k_ring_table.start[range] + index];
+						return {origin.xx + offset.dx, origin.yy + offset.dy};
+					}
 					return {
-						origin.xx + offset(index + range),
-						origin.yy + offset(index - range)
+						origin.xx + ring_offset(range, index + range),
+						origin.yy + ring_offset(range, index - range)
 					};
 				}
 
@@ -568,10 +584,6 @@ class with_range_iterable_t {
 			private:
 				Position origin;
 				int range = 0, index = 0;
-
-				constexpr int offset(int ii) const {
-					return std::clamp(range * 2 - std::abs(ii % (range * 8) - range * 4), -range, range);
-				}
 		};
 		using const_iterator = iterator;
 
@@ -650,6 +662,23 @@ class with_range_iterable_t {
 		constexpr iterator begin() const { return {origin, range, _begin}; }
 		constexpr iterator end() const { return {origin, range, _end}; }
 
+		// Invokes `function(int index)` with the flattened `xx * 50 + yy` index of each position, in
+		// iteration order
+		template <class Function>
+		constexpr void for_each_index(Function function) const {
+			int base = origin.xx * 50 + origin.yy;
+			if (range <= k_ring_table_max_range) {
+				const ring_offset_t* offsets = &k_ring_table.offsets[k_ring_table.start[range]];
+				for (int ii = _begin; ii < _end; ++ii) {
+					function(base + offsets[ii].delta);
+				}
+			} else {
+				for (Position pos : *this) {
+					function(pos.xx * 50 + pos.yy);
+				}
+			}
+		}
+
 	private:
 		constexpr with_range_iterable_t(
 			Position origin, int range, int begin, int end
@@ -937,7 +966,7 @@ class local_matrix_store_t {
 	protected:
 		static_assert(StoreBits >= Pack, "sizeof(Store) must be greater than or equal to pack bits");
 		static_assert(StoreBits % Pack == 0, "Store is not aligned to pack bits");
-		std::array<Store, (2500 * Pack + StoreBits / Pack) / StoreBits> costs;
+		std::array<Store, (2500 * Pack + StoreBits - 1) / StoreBits> costs;
 };
 
 // Specialization for direction_t packing
@@ -970,10 +999,173 @@ class local_matrix_store_t<direction_t, void, -1> : public local_matrix_store_t<
 		constexpr void fill(direction_t value) { store_t::fill(+value - 1); }
 };
 
-// Bitpack bools
+// Packed words with a bit set for each tile where `yy == row`
+template <int Words>
+constexpr std::array<uint32_t, Words> bool_matrix_row(int row) {
+	std::array<uint32_t, Words> words{};
+	for (int xx = 0; xx < 50; ++xx) {
+		int index = xx * 50 + row;
+		words[index >> 5] |= 1u << (index & 31);
+	}
+	return words;
+}
+
+// Bitpack bools. Tile `index` is bit `index & 31` of word `index >> 5`, so whole-matrix operations
+// can work on 32 tiles at a time. Bits past the last tile are kept clear.
 template <>
 class local_matrix_store_t<bool, void, -1> : public local_matrix_store_t<bool, int, 1> {
-	public: using local_matrix_store_t<bool, int, 1>::local_matrix_store_t;
+	private:
+		using store_t = local_matrix_store_t<bool, int, 1>;
+		static constexpr int k_words = (2500 + 31) / 32;
+		using words_t = std::array<uint32_t, k_words>;
+
+		// Tiles with `yy == 0` and `yy == 49`, which must not spill into the neighboring column when
+		// shifting by one tile
+		static constexpr words_t k_top_edge = bool_matrix_row<k_words>(0);
+		static constexpr words_t k_bottom_edge = bool_matrix_row<k_words>(49);
+		static constexpr uint32_t k_tail_mask = (1u << (2500 & 31)) - 1;
+
+		words_t load() const {
+			words_t words;
+			for (int ii = 0; ii < k_words; ++ii) {
+				words[ii] = costs[ii];
+			}
+			return words;
+		}
+
+		void store(const words_t& words) {
+			for (int ii = 0; ii < k_words; ++ii) {
+				costs[ii] = words[ii];
+			}
+			clear_tail();
+		}
+
+		void clear_tail() {
+			costs.back() &= k_tail_mask;
+		}
+
+		// Moves every tile `bits` indices higher, or lower if negative
+		static words_t shift(const words_t& words, int bits) {
+			words_t result{};
+			int word_shift = (bits < 0 ? -bits : bits) >> 5;
+			int bit_shift = (bits < 0 ? -bits : bits) & 31;
+			for (int ii = 0; ii < k_words; ++ii) {
+				int from = bits < 0 ? ii + word_shift : ii - word_shift;
+				int carry = bits < 0 ? from + 1 : from - 1;
+				uint32_t value = 0;
+				if (from >= 0 && from < k_words) {
+					value = bits < 0 ? words[from] >> bit_shift : words[from] << bit_shift;
+				}
+				if (bit_shift != 0 && carry >= 0 && carry < k_words) {
+					value |= bits < 0 ? words[carry] << (32 - bit_shift) : words[carry] >> (32 - bit_shift);
+				}
+				result[ii] = value;
+			}
+			return result;
+		}
+
+	public:
+		constexpr local_matrix_store_t() = default;
+		explicit local_matrix_store_t(bool value) { fill(value); }
+
+		void fill(bool value) {
+			store_t::fill(value);
+			clear_tail();
+		}
+
+		local_matrix_store_t& operator&=(const local_matrix_store_t& rhs) {
+			for (int ii = 0; ii < k_words; ++ii) {
+				costs[ii] &= rhs.costs[ii];
+			}
+			return *this;
+		}
+
+		local_matrix_store_t& operator|=(const local_matrix_store_t& rhs) {
+			for (int ii = 0; ii < k_words; ++ii) {
+				costs[ii] |= rhs.costs[ii];
+			}
+			return *this;
+		}
+
+		local_matrix_store_t& operator^=(const local_matrix_store_t& rhs) {
+			for (int ii = 0; ii < k_words; ++ii) {
+				costs[ii] ^= rhs.costs[ii];
+			}
+			return *this;
+		}
+
+		// Clears tiles which are set in `rhs`
+		local_matrix_store_t& subtract(const local_matrix_store_t& rhs) {
+			for (int ii = 0; ii < k_words; ++ii) {
+				costs[ii] &= ~rhs.costs[ii];
+			}
+			return *this;
+		}
+
+		local_matrix_store_t& invert() {
+			for (auto& word : costs) {
+				word = ~word;
+			}
+			clear_tail();
+			return *this;
+		}
+
+		int count() const {
+			int count = 0;
+			for (auto word : costs) {
+				count += __builtin_popcount(static_cast<uint32_t>(word));
+			}
+			return count;
+		}
+
+		bool any() const {
+			for (auto word : costs) {
+				if (word != 0) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Sets every tile within Chebyshev `range` of a set tile
+		local_matrix_store_t& dilate(int range) {
+			words_t words = load();
+			for (int ii = 0; ii < range; ++ii) {
+				// Along the column, then across columns which are 50 tiles apart
+				words_t up = shift(words, 1);
+				words_t down = shift(words, -1);
+				for (int jj = 0; jj < k_words; ++jj) {
+					words[jj] |= (up[jj] & ~k_top_edge[jj]) | (down[jj] & ~k_bottom_edge[jj]);
+				}
+				// The last tile shifted past the end and would come back down into column 49
+				words.back() &= k_tail_mask;
+				up = shift(words, 50);
+				down = shift(words, -50);
+				for (int jj = 0; jj < k_words; ++jj) {
+					words[jj] |= up[jj] | down[jj];
+				}
+			}
+			store(words);
+			return *this;
+		}
+
+		// Clears every tile within Chebyshev `range` of a clear tile. Tiles outside the room count as set.
+		local_matrix_store_t& erode(int range) {
+			return invert().dilate(range).invert();
+		}
+
+		// Invokes `function(local_position_t)` for each set tile, in index order
+		template <class Function>
+		void for_each(Function function) const {
+			for (int ii = 0; ii < k_words; ++ii) {
+				auto word = static_cast<uint32_t>(costs[ii]);
+				while (word != 0) {
+					int index = (ii << 5) + __builtin_ctz(word);
+					function(local_position_t(index / 50, index % 50));
+					word &= word - 1;
+				}
+			}
+		}
 };
 
 } // namespace detail
@@ -1003,6 +1195,26 @@ class local_matrix_t : public detail::local_matrix_store_t<Type, Store, Pack> {
 		constexpr void set(int xx, int yy, Type cost) { (*this)[xx * 50 + yy] = cost; }
 };
 
+inline local_matrix_t<bool> operator&(local_matrix_t<bool> left, const local_matrix_t<bool>& right) {
+	left &= right;
+	return left;
+}
+
+inline local_matrix_t<bool> operator|(local_matrix_t<bool> left, const local_matrix_t<bool>& right) {
+	left |= right;
+	return left;
+}
+
+inline local_matrix_t<bool> operator^(local_matrix_t<bool> left, const local_matrix_t<bool>& right) {
+	left ^= right;
+	return left;
+}
+
+inline local_matrix_t<bool> operator~(local_matrix_t<bool> matrix) {
+	matrix.invert();
+	return matrix;
+}
+
 } // namespace screeps
 
 // Hash specialization for hashing STL containers
@@ -0,0 +1,25 @@
+#pragma once
+#include "./path-finder.h"
+#include "./position.h"
+#include "./terrain.h"
+#include <vector>
+
+namespace screeps {
+
+// Finds where to put ramparts so that no path leads from a room's exits into a protected area. This
+// is a minimum vertex cut over the room's tiles, solved as max-flow on a graph where each tile is
+// split into an "in" and "out" node joined by an edge with the tile's cost.
+//
+// Walls and exit tiles never hold ramparts, and neither do protected tiles or tiles next to an exit
+// since the game doesn't allow building there. Results are deterministic for the same input.
+class rampart_planner_t {
+	public:
+		// Per-tile costs from `costs` replace the default of 1. A cost of 0 is treated as 1 and 255
+		// means the tile can't hold a rampart.
+		//
+		// Returns the cut tiles in index order, or throws `std::range_error` if a protected tile is
+		// next to an exit and can't be sealed.
+		static std::vector<local_position_t> min_cut(const terrain_t& terrain, const local_matrix_t<bool>& protect, const cost_matrix_t* costs = nullptr);
+};
+
+} // namespace screeps
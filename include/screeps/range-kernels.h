@@ -0,0 +1,28 @@
+#pragma once
+#include "./iterator.h"
+#include "./position.h"
+#include <cstddef>
+#include <cstdint>
+
+// Bulk versions of `position_t::range_to` for targeting loops over many positions. These use SSE2
+// in native builds and wasm SIMD when built with `-msimd128`, four positions at a time, with a scalar
+// fallback. Results always match the scalar functions: positions in different rooms are `INT_MAX`
+// apart.
+namespace screeps::range_kernels {
+
+// `ranges[ii] = positions[ii].range_to(target)`. `ranges` must be at least as long as `positions`.
+void range_to(pointer_container_t<const position_t> positions, position_t target, pointer_container_t<int32_t> ranges);
+
+// `mask[ii] = positions[ii].range_to(target) <= range`, and returns the number of set entries
+int within_range(pointer_container_t<const position_t> positions, position_t target, int range, pointer_container_t<uint8_t> mask);
+int count_within_range(pointer_container_t<const position_t> positions, position_t target, int range);
+
+// Index of the position closest to `target`, or -1 if none are in the same room. Ties go to the
+// lowest index.
+int closest(pointer_container_t<const position_t> positions, position_t target, int32_t* range = nullptr);
+
+// For every position, the index of the closest target and its range. Index is -1 if no target is in
+// the same room.
+void closest_each(pointer_container_t<const position_t> positions, pointer_container_t<const position_t> targets, pointer_container_t<int32_t> indices, pointer_container_t<int32_t> ranges);
+
+} // namespace screeps::range_kernels
@@ -72,12 +72,13 @@ struct tombstone_t : public game_object_t {
 	}
 };
 
+// Objects are stored contiguously per type across all rooms in `game_state_t`, and the containers
+// here are views of this room's part. Like everything else in the game state they're only valid
+// until the next `load`.
 class room_t {
 	friend class game_state_t;
 	private:
-		template <class Type>
-		using container_t = typename internal::memory_range_t<Type>::container_t;
-
+		// Where JS writes this room's objects, laid out by `game_state_t::allocate_rooms`
 		internal::memory_range_t<creep_t> creeps_memory;
 		internal::memory_range_t<dropped_resource_t> dropped_resources_memory;
 		internal::memory_range_t<source_t> sources_memory;
@@ -95,42 +96,18 @@ class room_t {
 		// terminal_t* terminal = nullptr;
 
 		pointer_container_t<construction_site_t> construction_sites;
-		container_t<creep_t> creeps;
-		container_t<dropped_resource_t> dropped_resources;
+		pointer_container_t<creep_t> creeps;
+		pointer_container_t<dropped_resource_t> dropped_resources;
 		pointer_container_t<flag_t> flags;
-		container_t<source_t> sources;
-		container_t<structure_union_t> structures;
-		container_t<tombstone_t> tombstones;
+		pointer_container_t<source_t> sources;
+		pointer_container_t<structure_union_t> structures;
+		pointer_container_t<tombstone_t> tombstones;
 
 	private:
-		template <class Function>
-		void invoke_containers_helper(Function& /* function */) {}
-
-		template <class Function, class Container, class Range, class... Rest>
-		void invoke_containers_helper(Function& function, Container& container, Range& range, Rest&... rest) {
-			function(container, range);
-			invoke_containers_helper(function, rest...);
-		}
-
-		template <class Function>
-		void invoke_containers(Function function) {
-			invoke_containers_helper(
-				function,
-				creeps, creeps_memory,
-				dropped_resources, dropped_resources_memory,
-				sources, sources_memory,
-				structures, structures_memory,
-				tombstones, tombstones_memory
-			);
-		}
-
 		static void init();
-	public:
-		static void ensure_capacity(room_t* room);
-	private:
 		void reset();
-		void shrink();
 		void update_pointers();
+		void update_structure_pointers();
 
 	public:
 		template <class Memory>
@@ -138,7 +115,6 @@ class room_t {
 			memory & location;
 			memory & mineral_holder & reinterpret_cast<int&>(mineral);
 			memory & energy_available & energy_capacity_available;
-			memory & creeps & dropped_resources & sources & structures & tombstones;
 			if constexpr (Memory::is_reader) {
 				update_pointers();
 			}
@@ -0,0 +1,53 @@
+#pragma once
+#include "./path-finder.h"
+#include "./position.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace screeps {
+
+// Plans long paths in two steps. First a route of rooms is found using a small graph of distances
+// between each room's exits, which is computed once from `terrain_t` and cached. Then the tile
+// path is found with `path_finder_t::search` limited to the rooms on that route.
+//
+// Graphs are cached per room and pair of terrain costs. Each is usually well under 1KB; the least
+// recently used ones are dropped past 1024 graphs, and `flush` drops them all.
+//
+// Room-level distances only use `plain_cost` and `swamp_cost`; cost matrices are applied during the
+// tile search. A room whose `room_callback` returns nullptr is avoided at both levels. Flee searches
+// go directly to `path_finder_t::search`.
+class route_planner_t {
+	public:
+		static constexpr uint16_t k_unreachable = 0xffff;
+
+		// A run of passable exit tiles along one side of a room. `side` is `top`, `right`, `bottom` or
+		// `left`, and `begin` and `end` are the first and last coordinate along that side.
+		struct exit_t {
+			direction_t side;
+			uint8_t begin;
+			uint8_t end;
+
+			position_t middle(room_location_t room) const;
+		};
+
+		struct room_graph_t {
+			room_location_t location;
+			std::vector<exit_t> exits;
+			// `distances[from * exits.size() + to]`
+			std::vector<uint16_t> distances;
+
+			uint16_t distance(int from, int to) const {
+				return distances[from * exits.size() + to];
+			}
+		};
+
+		// Returns the rooms to travel through, starting with the origin's room. Empty if there's no route.
+		static std::vector<room_location_t> find_route(position_t origin, const path_finder_t::goals_t& goals, const path_finder_t::options_t& options);
+		static path_finder_t::result_t search(position_t origin, const path_finder_t::goals_t& goals, const path_finder_t::options_t& options);
+
+		static std::shared_ptr<const room_graph_t> load_graph(room_location_t room, int plain_cost, int swamp_cost);
+		static void flush();
+};
+
+} // namespace screeps
@@ -0,0 +1,82 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+namespace screeps::cpu {
+
+// Runs prioritized tasks within a per-tick CPU budget. A task does one slice of work each time it's
+// called and returns true when it's finished. Each task gets at most one slice per tick and
+// unfinished tasks carry over to the next. Higher priorities run first, and tasks of equal priority
+// run in the order they were added.
+//
+// Before each slice the scheduler checks that `get_used()` plus the task's estimated slice cost fits
+// the budget, so a slow task is deferred rather than pushing the tick over the limit. Estimates jump
+// up to the slowest slice seen and decay slowly as faster slices are measured; they don't change
+// while a task is deferred.
+//
+// A task estimated at more than the whole budget would never run. Once it has starved for
+// `starvation_ticks` it runs first in a tick where the bucket is at least `bucket_low` and
+// `tickLimit` covers its estimate, so it bursts into the bucket instead of overrunning late in a
+// tick.
+class scheduler_t {
+	public:
+		using task_t = std::function<bool()>;
+
+		struct options_t {
+			// CPU left for work after the scheduler, like saving memory
+			double reserve = 2;
+			// Below `bucket_low` only `low_bucket_fraction` of the limit is used, to refill the bucket.
+			// Above `bucket_high` up to `burst_fraction` of the limit is used, bounded by `tickLimit`.
+			int bucket_low = 1000;
+			int bucket_high = 9000;
+			double low_bucket_fraction = 0.5;
+			double burst_fraction = 2;
+			// Pending tasks which haven't run for this many ticks count as starved
+			int starvation_ticks = 10;
+		};
+
+		struct statistics_t {
+			int ticks = 0;
+			int slices = 0;
+			int completed = 0;
+			// Times a task was skipped because its estimate didn't fit the remaining budget
+			int deferrals = 0;
+			// Pending tasks which have waited at least `starvation_ticks`, and the longest wait
+			int starved = 0;
+			int longest_wait = 0;
+			// Last tick's budget, and CPU used by tasks during it
+			double budget = 0;
+			double used = 0;
+		};
+
+		scheduler_t() = default;
+		explicit scheduler_t(const options_t& options) : options(options) {}
+
+		// `estimate` is the expected CPU of one slice, until the task has been measured. Returns an id
+		// for `cancel`.
+		int add(int priority, task_t task, double estimate = 0);
+		bool cancel(int id);
+		size_t size() const { return tasks.size(); }
+
+		// The CPU threshold for this tick, from `Game.cpu.limit` and the bucket
+		double budget() const;
+		// Runs slices until the budget is spent or nothing is left
+		void run();
+
+		const statistics_t& get_statistics() const { return statistics; }
+
+	private:
+		struct entry_t {
+			task_t task;
+			int id;
+			int priority;
+			double estimate;
+			int last_run;
+		};
+		std::vector<entry_t> tasks;
+		options_t options;
+		statistics_t statistics;
+		int next_id = 0;
+};
+
+} // namespace screeps::cpu
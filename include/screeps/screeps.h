@@ -1,15 +1,30 @@
 #pragma once
+#include "./arena.h"
 #include "./array.h"
 #include "./constants.h"
+#include "./cost-matrix-cache.h"
 #include "./creep.h"
+#include "./flow-field.h"
 #include "./game.h"
+#include "./incremental-path.h"
+#include "./intent.h"
 #include "./iterator.h"
+#include "./job.h"
+#include "./matrix-algorithms.h"
 #include "./memory.h"
 #include "./object.h"
+#include "./path-cache.h"
 #include "./path-finder.h"
 #include "./position.h"
+#include "./rampart-planner.h"
+#include "./range-kernels.h"
 #include "./resource.h"
 #include "./room.h"
+#include "./route-planner.h"
+#include "./scheduler.h"
 #include "./string.h"
 #include "./structure.h"
 #include "./terrain.h"
+#include "./threat-map.h"
+#include "./traffic.h"
+#include "./world-matrix.h"
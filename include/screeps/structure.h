@@ -10,6 +10,8 @@
 
 namespace screeps {
 
+class intent_queue_t;
+
 /**
  * unowned structures:
  * container, road, wall, portal
@@ -95,6 +97,7 @@ struct _spawn_structs_t {
 	// Stores spawning direction in a single 32-bit integer
 	class directions_t {
 		friend struct spawn_t;
+		friend class intent_queue_t;
 		private:
 			uint32_t bits = 0;
 		public:
@@ -1,4 +1,5 @@
 #pragma once
+#include "./constants.h"
 #include "./position.h"
 #include <cstdint>
 #include <memory>
@@ -11,10 +12,27 @@ class terrain_t : public local_matrix_t<uint8_t, uint8_t, 2> {
 		static constexpr uint8_t plain = 0;
 		static constexpr uint8_t wall = 1;
 		static constexpr uint8_t swamp = 2;
+
+		// Terrain is kept in a least-recently-used cache. `size` and `budget` are in bytes. A "hit" is
+		// any load which didn't have to go through `Game.map`.
+		struct cache_statistics_t {
+			int hits = 0;
+			int misses = 0;
+			int evictions = 0;
+			int size = 0;
+			int budget = kTerrainCacheSize;
+		};
+
 		terrain_t() = default;
 		static void flush();
 		static std::shared_ptr<terrain_t> load(room_location_t room);
 
+		// Pinned rooms are never evicted from the cache. Use this for owned and remote rooms.
+		static void pin(room_location_t room);
+		static void unpin(room_location_t room);
+		static void set_cache_budget(int bytes);
+		static const cache_statistics_t& get_cache_statistics();
+
 	protected:
 		explicit terrain_t(room_location_t room);
 		static void insert(room_location_t room, std::shared_ptr<terrain_t> terrain);
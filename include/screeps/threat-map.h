@@ -0,0 +1,58 @@
+#pragma once
+#include "./path-finder.h"
+#include "./position.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace screeps {
+
+struct creep_t;
+class terrain_t;
+
+// Safety map of a room: how many steps the nearest hostile needs before it can attack each tile.
+// Every tile within a hostile's attack range is a source, and one breadth-first pass outward from all
+// sources fills in the rest, so fleeing creeps can pick a direction with a lookup instead of running a
+// flee search. The map only depends on the hostiles, so every creep in the room can share it.
+//
+// Hostiles walk around walls and anything the cost matrix marks impassable. Attacks reach through them.
+class threat_map_t {
+	public:
+		using safety_matrix_t = local_matrix_t<uint8_t>;
+		// No hostile can reach the tile
+		static constexpr uint8_t k_safe = 0xff;
+
+		struct threat_t {
+			local_position_t pos;
+			int range;
+
+			bool operator==(const threat_t& rhs) const { return pos == rhs.pos && range == rhs.range; }
+		};
+
+		threat_map_t(room_location_t room, const std::vector<threat_t>& threats, const cost_matrix_t* cost_matrix = nullptr);
+
+		// 0 means a hostile can attack the tile right now
+		uint8_t safety(local_position_t pos) const { return safeties[pos]; }
+		const safety_matrix_t& safety() const { return safeties; }
+		// Neighbor which is furthest from any hostile, or empty if no neighbor is better than `pos`
+		std::optional<direction_t> flee_direction(local_position_t pos) const;
+
+		// Attack range of a creep's active parts, or empty if it can't attack
+		static std::optional<threat_t> threat(const creep_t& creep);
+
+		// Returns the map for the room if it was built from the same threats and cost matrix, or builds
+		// a new one.
+		static std::shared_ptr<const threat_map_t> load(room_location_t room, const std::vector<threat_t>& threats, const cost_matrix_t* cost_matrix = nullptr);
+		static void flush();
+
+	private:
+		std::shared_ptr<terrain_t> terrain;
+		std::optional<cost_matrix_t> cost_matrix;
+		std::vector<threat_t> threats;
+		safety_matrix_t safeties;
+
+		bool is_passable(local_position_t pos) const;
+};
+
+} // namespace screeps
@@ -0,0 +1,66 @@
+#pragma once
+#include "./path-finder.h"
+#include "./position.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace screeps {
+
+class terrain_t;
+
+// Decides one move per creep in a room so that creeps don't walk into each other. Each creep says
+// which way it wants to go for the next few ticks. Creeps are planned in order of priority:
+// a creep may step into a tile that another creep is leaving in the same tick, two creeps may swap
+// places, and idle creeps standing in the way are pushed aside, preferring tiles which aren't on
+// anyone's upcoming path. Upcoming paths are kept in a space-time reservation table with one
+// `local_matrix_t` per tick.
+//
+// The cost matrix should describe structures only; other creeps are handled by the planner.
+class traffic_planner_t {
+	public:
+		static constexpr int k_window = 4;
+
+		struct agent_t {
+			local_position_t pos;
+			// Directions the creep wants to move, starting this tick. Zero length means the creep is idle
+			// and may be pushed.
+			std::array<direction_t, k_window> steps;
+			int length = 0;
+			int priority = 0;
+			// False for fatigued or spawning creeps, which are never moved or pushed
+			bool can_move = true;
+		};
+
+		explicit traffic_planner_t(room_location_t room, const cost_matrix_t* cost_matrix = nullptr);
+
+		// Returns an id used to look up the result
+		int add(const agent_t& agent);
+		void plan();
+		// Direction to move this tick, or empty to stay put
+		std::optional<direction_t> direction(int id) const { return directions[id]; }
+		void clear();
+
+	private:
+		enum struct state_t : uint8_t { unplanned, planning, planned };
+		using layer_t = local_matrix_t<uint16_t>;
+
+		std::shared_ptr<terrain_t> terrain;
+		const cost_matrix_t* cost_matrix;
+		std::vector<agent_t> agents;
+		std::vector<state_t> states;
+		std::vector<std::optional<direction_t>> directions;
+		// `reserved[0]` is where creeps stand now, `reserved[tt]` is who will be on a tile `tt` ticks
+		// from now. Values are agent id + 1, and 0 is free.
+		std::array<layer_t, k_window + 1> reserved;
+
+		bool is_passable(local_position_t pos) const;
+		bool plan_agent(int id);
+		bool make_room(int id, int requester);
+		bool push(int id, int requester);
+		void move(int id, local_position_t to);
+};
+
+} // namespace screeps
@@ -0,0 +1,127 @@
+#pragma once
+#include "./position.h"
+#include <memory>
+#include <unordered_map>
+
+namespace screeps {
+
+// Matrix covering any number of rooms, addressed by world coordinates so cross-room code doesn't
+// have to convert coordinates by hand. Rooms are allocated the first time they're written, and reads
+// from rooms which were never written return the default value. The last room accessed is cached,
+// so walking a neighborhood only looks up the map again when it crosses into another room.
+//
+// `position_t` converts implicitly to `detail::world_position_t`.
+template <class Type>
+class world_matrix_t {
+	public:
+		using world_position_t = detail::world_position_t;
+		using room_matrix_t = local_matrix_t<Type>;
+		using reference = typename room_matrix_t::reference;
+
+		explicit world_matrix_t(Type default_value = Type{}) : default_value(default_value) {}
+
+		world_matrix_t(const world_matrix_t&) = delete;
+		world_matrix_t& operator=(const world_matrix_t&) = delete;
+		world_matrix_t(world_matrix_t&&) noexcept = default;
+		world_matrix_t& operator=(world_matrix_t&&) noexcept = default;
+
+		Type get(world_position_t pos) const {
+			const room_matrix_t* matrix = find(pos.location());
+			return matrix == nullptr ? default_value : (*matrix)[index(pos)];
+		}
+
+		// Allocates the room if needed
+		reference operator[](world_position_t pos) {
+			return room(pos.location())[index(pos)];
+		}
+
+		void set(world_position_t pos, Type value) {
+			(*this)[pos] = value;
+		}
+
+		// Returns the room's matrix, allocating it filled with the default value if needed
+		room_matrix_t& room(room_location_t location) {
+			room_matrix_t* matrix = find(location);
+			if (matrix == nullptr) {
+				auto& slot = rooms[location];
+				slot = std::make_unique<room_matrix_t>(default_value);
+				matrix = slot.get();
+				cached_location = location;
+				cached_room = matrix;
+			}
+			return *matrix;
+		}
+
+		// nullptr if the room was never written
+		room_matrix_t* find(room_location_t location) {
+			return const_cast<room_matrix_t*>(const_cast<const world_matrix_t*>(this)->find(location));
+		}
+
+		const room_matrix_t* find(room_location_t location) const {
+			if (location != cached_location) {
+				auto ii = rooms.find(location);
+				cached_location = location;
+				cached_room = ii == rooms.end() ? nullptr : ii->second.get();
+			}
+			return cached_room;
+		}
+
+		void erase(room_location_t location) {
+			rooms.erase(location);
+			if (location == cached_location) {
+				cached_room = nullptr;
+			}
+		}
+
+		void clear() {
+			rooms.clear();
+			cached_location = room_location_t::null;
+			cached_room = nullptr;
+		}
+
+		size_t room_count() const { return rooms.size(); }
+
+		// Invokes `function(room_location_t, room_matrix_t&)` for each allocated room
+		template <class Function>
+		void for_each_room(Function function) {
+			for (auto& [location, matrix] : rooms) {
+				function(location, *matrix);
+			}
+		}
+
+		// Invokes `function(world_position_t)` for the 8 surrounding tiles, crossing into neighboring
+		// rooms at the edges. These are plain grid neighbors; `position_t::world_neighbors` follows the
+		// game's movement rules at exits instead.
+		template <class Function>
+		static void for_each_neighbor(world_position_t pos, Function function) {
+			for (int dx = -1; dx <= 1; ++dx) {
+				for (int dy = -1; dy <= 1; ++dy) {
+					if (dx != 0 || dy != 0) {
+						function(world_position_t(pos.xx + dx, pos.yy + dy));
+					}
+				}
+			}
+		}
+
+		// Invokes `function(world_position_t)` for every tile within `range`, including `pos`
+		template <class Function>
+		static void for_each_in_range(world_position_t pos, int range, Function function) {
+			for (int dx = -range; dx <= range; ++dx) {
+				for (int dy = -range; dy <= range; ++dy) {
+					function(world_position_t(pos.xx + dx, pos.yy + dy));
+				}
+			}
+		}
+
+	private:
+		std::unordered_map<room_location_t, std::unique_ptr<room_matrix_t>> rooms;
+		Type default_value;
+		mutable room_location_t cached_location = room_location_t::null;
+		mutable const room_matrix_t* cached_room = nullptr;
+
+		static int index(world_position_t pos) {
+			return (pos.xx % 50) * 50 + pos.yy % 50;
+		}
+};
+
+} // namespace screeps
@@ -0,0 +1,115 @@
+'use strict';
+const ObjectLib = require('object');
+const PositionLib = require('position');
+const StringLib = require('string');
+const util = require('util');
+
+// intent_queue_t::record_t
+let intentSizeof, intentObject, intentTarget, intentResult, intentArgument, intentAmount;
+let intentName, intentNameLength, intentPos, intentKind;
+
+function readAmount(env, ptr) {
+	let amount = env.readInt32(ptr + intentAmount);
+	return amount === -1 ? undefined : amount;
+}
+
+function readDirections(bits) {
+	if (bits === 0) {
+		return;
+	}
+	let directions = [];
+	do {
+		directions.push(bits & 0x0f);
+		bits >>>= 4;
+	} while (bits !== 0);
+	return directions;
+}
+
+// nb: must match intent_queue_t::kind_t
+const kinds = [
+	// build
+	(env, ptr, object, target) => object.build(target(ptr + intentTarget)),
+	// drop
+	(env, ptr, object) => object.drop(ObjectLib.readResourceType(env.readInt32(ptr + intentArgument)), readAmount(env, ptr)),
+	// harvest
+	(env, ptr, object, target) => object.harvest(target(ptr + intentTarget)),
+	// move
+	(env, ptr, object) => object.move(env.readInt32(ptr + intentArgument)),
+	// pickup
+	(env, ptr, object, target) => object.pickup(target(ptr + intentTarget)),
+	// repair
+	(env, ptr, object, target) => object.repair(target(ptr + intentTarget)),
+	// suicide
+	(env, ptr, object) => object.suicide(),
+	// transfer
+	(env, ptr, object, target) => object.transfer(
+		target(ptr + intentTarget),
+		ObjectLib.readResourceType(env.readInt32(ptr + intentArgument)),
+		readAmount(env, ptr)
+	),
+	// upgrade_controller
+	(env, ptr, object, target) => object.upgradeController(target(ptr + intentTarget)),
+	// withdraw
+	(env, ptr, object, target) => object.withdraw(
+		target(ptr + intentTarget),
+		ObjectLib.readResourceType(env.readInt32(ptr + intentArgument)),
+		readAmount(env, ptr)
+	),
+	// spawn_creep
+	(env, ptr, object, target, name) => {
+		let directions = readDirections(env.readUint32(ptr + intentAmount));
+		return object.spawnCreep(
+			util.handleGet(env.readInt32(ptr + intentArgument)),
+			name,
+			directions === undefined ? undefined : { directions }
+		);
+	},
+	// create_construction_site, which has no object
+	(env, ptr, object, target, name) => {
+		let pos = PositionLib.read(env, ptr + intentPos);
+		let room = Game.rooms[pos.roomName];
+		if (room === undefined) {
+			return ERR_INVALID_TARGET;
+		}
+		return room.createConstructionSite(pos.x, pos.y, ObjectLib.readStructureType(env.readInt32(ptr + intentArgument)), name);
+	},
+];
+const kCreateConstructionSite = kinds.length - 1;
+
+const that = module.exports = {
+	initIntentLayout(layout) {
+		intentSizeof = layout.sizeof;
+		intentObject = layout.object;
+		intentTarget = layout.target;
+		intentResult = layout.result;
+		intentArgument = layout.argument;
+		intentAmount = layout.amount;
+		intentName = layout.name;
+		intentNameLength = layout.nameLength;
+		intentPos = layout.pos;
+		intentKind = layout.kind;
+	},
+
+	// Submits the records in [ptr, end) and writes back each one's return code. Objects are looked up
+	// once per flush no matter how many intents refer to them.
+	flush(env, ptr, end, names) {
+		let objects = new Map;
+		let lookup = function(idPtr) {
+			let id = StringLib.readId(env, idPtr);
+			let object = objects.get(id);
+			if (object === undefined) {
+				object = Game.getObjectById(id);
+				objects.set(id, object);
+			}
+			return object;
+		};
+		for (; ptr < end; ptr += intentSizeof) {
+			let kind = env.readUint8(ptr + intentKind);
+			let nameLength = env.readUint32(ptr + intentNameLength);
+			let name = nameLength === 0 ? undefined : StringLib.readOneByteStringData(env, names + env.readUint32(ptr + intentName), nameLength);
+			let object = kind === kCreateConstructionSite ? undefined : lookup(ptr + intentObject);
+			let result = object === null ? ERR_INVALID_TARGET : kinds[kind](env, ptr, object, lookup, name);
+			env.writeInt32(ptr + intentResult, result);
+		}
+	},
+};
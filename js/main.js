@@ -166,6 +166,7 @@ function* initialize() {
 	// Load our modules
 	const screeps = {
 		array: require('array'),
+		intent: require('intent'),
 		object: require('object'),
 		position: require('position'),
 		string: require('string'),
@@ -321,6 +322,7 @@ function* initialize() {
 		try {
 			didExitCleanly = false;
 			mod.__Z4loopv();
+			mod.__ZN7screeps14intent_queue_t10flush_tickEv();
 			didExitCleanly = true;
 		} catch (err) {
 			if (typeof err === 'number') {
@@ -319,6 +319,7 @@ const that = module.exports = {
 		rooms.sort(function(left, right) {
 			return PositionLib.parseRoomName(left.name) - PositionLib.parseRoomName(right.name);
 		});
+		let roomObjects = [];
 		for (let room of rooms) {
 			// Find pointer to room structure
 			let roomId = PositionLib.parseRoomName(room.name);
@@ -346,7 +347,13 @@ const that = module.exports = {
 					break;
 				}
 			} while (true);
-			that.writeRoom(env, roomPtr, roomId, room);
+			roomObjects.push(that.findRoomObjects(env, roomPtr, roomId, room));
+		}
+
+		// Every room's objects share one container per type, so they're all sized before any are written
+		env.__ZN7screeps12game_state_t14allocate_roomsEPS0_(ptr);
+		for (let objects of roomObjects) {
+			that.writeRoom(env, objects);
 		}
 
 		// Write active segments
@@ -360,29 +367,26 @@ const that = module.exports = {
 		env.writeUint32(ptr + gameMemory, segmentCount);
 	},
 
-	writeRoom(env, ptr, roomId, room) {
-		// Write room data
+	// Writes room data and how many objects the room needs, which `allocate_rooms` picks up
+	findRoomObjects(env, ptr, roomId, room) {
 		env.writeUint16(ptr + roomLocation, roomId);
 		env.writeInt32(ptr + roomEnergyAvailable, room.energyAvailable);
 		env.writeInt32(ptr + roomEnergyCapacityAvailable, room.energyCapacityAvailable);
 
-		// Ensure vector capacity
 		let creeps = room.find(FIND_CREEPS);
 		let droppedResources = room.find(FIND_DROPPED_RESOURCES);
 		let sources = room.find(FIND_SOURCES);
 		let structures = room.find(FIND_STRUCTURES);
-		let needsResize =
-			env.readUint32(ptr + roomCreeps) < creeps.length + 3 ||
-			env.readUint32(ptr + roomDroppedResources) < droppedResources.length ||
-			env.readUint32(ptr + roomSources) < sources.length ||
-			env.readUint32(ptr + roomStructures) < structures.length;
+		// Extra creeps are for spawning creeps, which are written by their spawn
 		env.writeUint32(ptr + roomCreeps, creeps.length + 3);
 		env.writeUint32(ptr + roomDroppedResources, droppedResources.length);
 		env.writeUint32(ptr + roomSources, sources.length);
 		env.writeUint32(ptr + roomStructures, structures.length);
-		if (needsResize) {
-			env.__ZN7screeps6room_t15ensure_capacityEPS0_(ptr);
-		}
+		return { ptr, room, creeps, droppedResources, sources, structures };
+	},
+
+	writeRoom(env, objects) {
+		let { ptr, room, creeps, droppedResources, sources, structures } = objects;
 
 		// Write structures
 		let creepsData = env.readPtr(ptr + roomCreeps + env.ptrSize);
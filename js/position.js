@@ -47,6 +47,16 @@ const that = module.exports = {
 		}
 	},
 
+	// Reads a `position_t` into a `RoomPosition`
+	read(env, ptr) {
+		return new RoomPosition(env.readInt8(ptr), env.readInt8(ptr + 1), that.generateRoomName(env.readUint16(ptr + 2)));
+	},
+
+	// Writes a `RoomPosition` into a `position_t`
+	write(env, ptr, pos) {
+		env.writeInt32(ptr, (that.parseRoomName(pos.roomName) << 16) | (pos.y << 8) | pos.x);
+	},
+
 	getVisual(bits) {
 		let visual = visualCache.get(bits);
 		if (visual === undefined) {
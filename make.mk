@@ -8,7 +8,7 @@ include $(SCREEPS_PATH)/make/patterns.mk
 CXXFLAGS += -I$(SCREEPS_PATH)/include
 EXPORTED_FUNCTIONS += __Z4loopv
 WASM_EMFLAGS += -s EXPORTED_FUNCTIONS=$$(echo $(EXPORTED_FUNCTIONS) | $(TO_JSON))
-RUNTIME := array.js console.js error.js main.js object.js position.js string.js util.js vector.js inflate.js inflate.wasm.wasm
+RUNTIME := array.js console.js error.js intent.js main.js object.js position.js string.js util.js vector.js inflate.js inflate.wasm.wasm
 
 # Bytecode targets
 BC_FILES = $(addprefix $(BUILD_PATH)/,$(patsubst %.cc,%.bc,$(SRCS)))
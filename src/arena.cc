@@ -0,0 +1,69 @@
+#include <screeps/arena.h>
+#include <algorithm>
+#include <cstdlib>
+
+namespace screeps {
+
+tick_arena_t::~tick_arena_t() {
+	for (auto& block : blocks) {
+		std::free(block.data);
+	}
+}
+
+tick_arena_t& tick_arena_t::get() {
+	static tick_arena_t arena;
+	return arena;
+}
+
+void* tick_arena_t::allocate_block(size_t bytes, size_t alignment) {
+	// Each block is at least double the last one
+	size_t size = std::max(bytes + alignment, blocks.empty() ? k_initial_block_size : blocks.back().size * 2);
+	auto* data = static_cast<char*>(std::malloc(size));
+	if (data == nullptr) {
+		throw std::bad_alloc();
+	}
+	if (!blocks.empty()) {
+		retired += cursor - blocks.back().data;
+	}
+	blocks.push_back({data, size});
+	cursor = align(data, alignment) + bytes;
+	limit = data + size;
+	return cursor - bytes;
+}
+
+void tick_arena_t::reset() {
+	high_water = std::max(high_water, size());
+	if (blocks.size() > 1) {
+		// Replace the blocks with one large enough for everything this tick used
+		size_t total = capacity();
+		for (auto& block : blocks) {
+			std::free(block.data);
+		}
+		blocks.clear();
+		auto* data = static_cast<char*>(std::malloc(total));
+		if (data != nullptr) {
+			blocks.push_back({data, total});
+		}
+	}
+	retired = 0;
+	cursor = blocks.empty() ? nullptr : blocks.front().data;
+	limit = blocks.empty() ? nullptr : blocks.front().data + blocks.front().size;
+}
+
+size_t tick_arena_t::size() const {
+	return blocks.empty() ? 0 : retired + (cursor - blocks.back().data);
+}
+
+size_t tick_arena_t::peak() const {
+	return std::max(high_water, size());
+}
+
+size_t tick_arena_t::capacity() const {
+	size_t total = 0;
+	for (auto& block : blocks) {
+		total += block.size;
+	}
+	return total;
+}
+
+} // namespace screeps
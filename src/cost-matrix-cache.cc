@@ -0,0 +1,127 @@
+#include <screeps/cost-matrix-cache.h>
+#include <screeps/game.h>
+#include <screeps/terrain.h>
+#include <screeps/threat-map.h>
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <unordered_map>
+
+namespace screeps {
+
+namespace {
+
+constexpr int k_layer_mask = cost_matrix_cache_t::creeps | cost_matrix_cache_t::hostile_zones;
+
+struct room_entry_t {
+	bool visible = false;
+	cost_matrix_t base;
+	// Indexed by layer flags; 0 is unused
+	std::array<std::optional<cost_matrix_t>, k_layer_mask + 1> layers;
+};
+
+static const game_state_t* current_game = nullptr;
+static std::unordered_map<room_location_t, room_entry_t> cached_rooms;
+static const cost_matrix_t empty_matrix(0);
+
+bool is_walkable(structure_t::type_t type, bool my) {
+	switch (type) {
+		case structure_t::container:
+		case structure_t::road:
+			return true;
+		case structure_t::rampart:
+			return my;
+		default:
+			return false;
+	}
+}
+
+} // namespace
+
+void cost_matrix_cache_t::update(const game_state_t& game) {
+	current_game = &game;
+	for (auto& [location, entry] : cached_rooms) {
+		entry.visible = false;
+		for (auto& layer : entry.layers) {
+			layer.reset();
+		}
+	}
+	for (auto& [location, room] : game.rooms) {
+		auto& entry = cached_rooms[location];
+		entry.visible = true;
+		entry.base.fill(0);
+		for (const structure_t& structure : room.structures) {
+			uint8_t& cost = entry.base[~structure.pos];
+			if (structure.type == structure_t::portal || !is_walkable(structure.type, structure.my)) {
+				cost = 0xff;
+			} else if (structure.type == structure_t::road && cost != 0xff) {
+				cost = 1;
+			}
+		}
+		for (auto& site : room.construction_sites) {
+			if (site.my && !is_walkable(site.type, true)) {
+				entry.base[~site.pos] = 0xff;
+			}
+		}
+	}
+}
+
+const cost_matrix_t* cost_matrix_cache_t::get(room_location_t room, int layers) {
+	auto ii = cached_rooms.find(room);
+	if (ii == cached_rooms.end()) {
+		return nullptr;
+	}
+	auto& entry = ii->second;
+	layers &= k_layer_mask;
+	if (layers == base) {
+		return &entry.base;
+	}
+	auto& matrix = entry.layers[layers];
+	if (matrix) {
+		return &*matrix;
+	}
+	matrix = entry.base;
+	if (!entry.visible) {
+		return &*matrix;
+	}
+	const room_t& state = current_game->rooms.at(room);
+	if (layers & hostile_zones) {
+		auto terrain = terrain_t::load(room);
+		for (auto& creep : state.creeps) {
+			if (creep.my) {
+				continue;
+			}
+			auto threat = threat_map_t::threat(creep);
+			if (!threat) {
+				continue;
+			}
+			for (auto pos : threat->pos.within_range(threat->range)) {
+				uint8_t& cost = (*matrix)[pos];
+				// A nonzero cost would make walls passable
+				if (cost != 0xff && !((*terrain)[pos.xx * 50 + pos.yy] & terrain_t::wall)) {
+					cost = std::max(cost, k_hostile_zone_cost);
+				}
+			}
+		}
+	}
+	if (layers & creeps) {
+		for (auto& creep : state.creeps) {
+			(*matrix)[~creep.pos] = 0xff;
+		}
+	}
+	return &*matrix;
+}
+
+path_finder_t::callback_t cost_matrix_cache_t::callback(int layers) {
+	return [layers](room_location_t room) {
+		const cost_matrix_t* matrix = get(room, layers);
+		return matrix == nullptr ? &empty_matrix : matrix;
+	};
+}
+
+void cost_matrix_cache_t::flush() {
+	cached_rooms.clear();
+	current_game = nullptr;
+}
+
+} // namespace screeps
@@ -1,13 +1,45 @@
+#include <screeps/arena.h>
 #include <screeps/cpu.h>
 #include "./javascript.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
 
 namespace {
 	static screeps::cpu::native_heap_t heap_status;
+	static screeps::cpu::allocation_profile_t allocation_profile;
+	static bool profiler_enabled = false;
+	static thread_local int current_tag = 0;
+	static screeps::cpu::cpu_profile_t cpu_profile;
+	// Open calls of each zone, to find the outermost call of a recursive zone
+	static std::array<int, screeps::cpu::cpu_profile_t::k_max_zones> zone_depths;
+	static thread_local screeps::cpu::profile_zone_t* current_zone = nullptr;
+	static int profile_window = 0;
+	// Stand-ins for `Game.cpu` in native builds
+	static double native_tick_start = 0;
+	static int native_limit = 20;
+	static int native_tick_limit = 500;
+	static int native_bucket = 10000;
+
+	// Defined after the allocator overrides, which they're called from
+	void profile_allocation(void* ptr, size_t size);
+	void profile_free(void* ptr, size_t size);
 }
 
 namespace screeps::cpu {
 
 const native_heap_t& get_native_heap_statistics() {
+	const auto& arena = tick_arena_t::get();
+	heap_status.arena_size = arena.size();
+	heap_status.arena_peak = arena.peak();
 	return heap_status;
 }
 
@@ -18,11 +50,214 @@ void halt() {
 	std::terminate();
 }
 
+allocation_tag_t::allocation_tag_t(const char* name) : previous(current_tag) {
+	if (!profiler_enabled) {
+		return;
+	}
+	auto& tags = allocation_profile.tags;
+	for (int ii = 1; ii < allocation_profile.tag_count; ++ii) {
+		if (tags[ii].name == name || std::strcmp(tags[ii].name, name) == 0) {
+			current_tag = ii;
+			return;
+		}
+	}
+	if (allocation_profile.tag_count < allocation_profile_t::k_max_tags) {
+		tags[allocation_profile.tag_count].name = name;
+		current_tag = allocation_profile.tag_count++;
+	}
+}
+
+allocation_tag_t::~allocation_tag_t() {
+	current_tag = previous;
+}
+
+void enable_allocation_profiler(bool enabled) {
+	profiler_enabled = enabled;
+}
+
+const allocation_profile_t& get_allocation_profile() {
+	return allocation_profile;
+}
+
+void begin_allocation_tick() {
+	allocation_profile.last_tick = allocation_profile.tick;
+	allocation_profile.tick = {heap_status.size, 0, 0};
+}
+
+void print_allocation_profile() {
+	print_allocation_profile(std::cout);
+}
+
+void print_allocation_profile(std::ostream& os) {
+	const auto& profile = allocation_profile;
+	os <<"heap: " <<heap_status.size <<" bytes in " <<(heap_status.allocs - heap_status.frees) <<" blocks\n"
+		<<"last tick: peak " <<profile.last_tick.peak <<" bytes, churn " <<profile.last_tick.churn
+		<<" bytes in " <<profile.last_tick.allocs <<" blocks\n";
+	for (int ii = 0; ii < allocation_profile_t::k_size_classes; ++ii) {
+		const auto& counts = profile.size_classes[ii];
+		if (counts.allocs != 0) {
+			if (ii + 1 == allocation_profile_t::k_size_classes) {
+				os <<"  >" <<(1 << (ii - 1));
+			} else {
+				os <<"  <=" <<(1 << ii);
+			}
+			os <<": " <<(counts.allocs - counts.frees) <<" live, " <<counts.live_bytes <<" bytes, "
+				<<counts.allocs <<" allocs\n";
+		}
+	}
+	for (int ii = 0; ii < profile.tag_count; ++ii) {
+		const auto& tag = profile.tags[ii];
+		if (tag.counts.allocs != 0) {
+			os <<"  [" <<(ii == 0 ? "untagged" : tag.name) <<"] " <<(tag.counts.allocs - tag.counts.frees)
+				<<" live, " <<tag.counts.live_bytes <<" bytes, " <<tag.counts.allocs <<" allocs\n";
+		}
+	}
+}
+
+double now() {
+#ifdef __EMSCRIPTEN__
+	return emscripten_get_now();
+#else
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+double get_used() {
+#ifdef JAVASCRIPT
+	return EM_ASM_DOUBLE({ return Game.cpu.getUsed(); });
+#else
+	return now() - native_tick_start;
+#endif
+}
+
+int get_limit() {
+#ifdef JAVASCRIPT
+	return EM_ASM_INT({ return Game.cpu.limit; });
+#else
+	return native_limit;
+#endif
+}
+
+int get_tick_limit() {
+#ifdef JAVASCRIPT
+	return EM_ASM_INT({ return Game.cpu.tickLimit; });
+#else
+	return native_tick_limit;
+#endif
+}
+
+int get_bucket() {
+#ifdef JAVASCRIPT
+	return EM_ASM_INT({ return Game.cpu.bucket; });
+#else
+	return native_bucket;
+#endif
+}
+
+void set_native_limits(int limit, int tick_limit, int bucket) {
+	native_tick_start = now();
+	native_limit = limit;
+	native_tick_limit = tick_limit;
+	native_bucket = bucket;
+}
+
+profile_zone_t::profile_zone_t(int zone) : parent(current_zone), start(0), zone(profile_window == 0 ? -1 : zone) {
+	if (this->zone != -1) {
+		++zone_depths[zone];
+		current_zone = this;
+		start = now();
+	}
+}
+
+profile_zone_t::~profile_zone_t() {
+	if (zone == -1) {
+		return;
+	}
+	double elapsed = now() - start;
+	auto& statistics = cpu_profile.zones[zone];
+	++statistics.calls;
+	statistics.exclusive += elapsed - children;
+	if (--zone_depths[zone] == 0) {
+		statistics.inclusive += elapsed;
+	}
+	current_zone = parent;
+	if (parent != nullptr) {
+		parent->children += elapsed;
+	}
+}
+
+int profile_zone_t::register_zone(const char* name) {
+	for (int ii = 0; ii < cpu_profile.zone_count; ++ii) {
+		if (cpu_profile.zones[ii].name == name || std::strcmp(cpu_profile.zones[ii].name, name) == 0) {
+			return ii;
+		}
+	}
+	if (cpu_profile.zone_count == cpu_profile_t::k_max_zones) {
+		return -1;
+	}
+	cpu_profile.zones[cpu_profile.zone_count].name = name;
+	return cpu_profile.zone_count++;
+}
+
+void enable_cpu_profiler(int ticks) {
+	profile_window = ticks;
+	reset_cpu_profile();
+}
+
+const cpu_profile_t& get_cpu_profile() {
+	return cpu_profile;
+}
+
+void begin_cpu_profile_tick() {
+	if (profile_window == 0) {
+		return;
+	}
+	if (cpu_profile.ticks == profile_window) {
+		print_cpu_profile();
+		reset_cpu_profile();
+	}
+	++cpu_profile.ticks;
+}
+
+void reset_cpu_profile() {
+	// Zone ids are cached by `SCREEPS_PROFILE_ZONE` so names stay registered
+	for (int ii = 0; ii < cpu_profile.zone_count; ++ii) {
+		cpu_profile.zones[ii] = {cpu_profile.zones[ii].name, 0, 0, 0};
+	}
+	cpu_profile.ticks = 0;
+}
+
+void print_cpu_profile() {
+	print_cpu_profile(std::cout);
+}
+
+void print_cpu_profile(std::ostream& os) {
+	std::array<const zone_statistics_t*, cpu_profile_t::k_max_zones> sorted;
+	int count = 0;
+	for (int ii = 0; ii < cpu_profile.zone_count; ++ii) {
+		if (cpu_profile.zones[ii].calls != 0) {
+			sorted[count++] = &cpu_profile.zones[ii];
+		}
+	}
+	std::sort(sorted.begin(), sorted.begin() + count, [](const zone_statistics_t* left, const zone_statistics_t* right) {
+		return left->exclusive > right->exclusive;
+	});
+	double ticks = std::max(cpu_profile.ticks, 1);
+	auto flags = os.flags();
+	auto precision = os.precision();
+	os <<"cpu profile over " <<cpu_profile.ticks <<" ticks, per tick: exclusive, inclusive, calls\n" <<std::fixed <<std::setprecision(3);
+	for (int ii = 0; ii < count; ++ii) {
+		os <<"  " <<sorted[ii]->name <<": " <<(sorted[ii]->exclusive / ticks) <<"ms, "
+			<<(sorted[ii]->inclusive / ticks) <<"ms, " <<(sorted[ii]->calls / ticks) <<"\n";
+	}
+	os.flags(flags);
+	os.precision(precision);
+}
+
 } // namespace screeps::cpu
 
 
 #ifdef __EMSCRIPTEN__
-#include <emscripten.h>
 extern "C" {
 
 extern void* emscripten_builtin_malloc(size_t size);
@@ -31,14 +266,22 @@ extern size_t malloc_usable_size(void* ptr);
 
 void* malloc(size_t size) {
 	void* ptr = emscripten_builtin_malloc(size);
-	heap_status.size += malloc_usable_size(ptr);
+	size_t usable = malloc_usable_size(ptr);
+	heap_status.size += usable;
 	++heap_status.allocs;
+	if (profiler_enabled) {
+		profile_allocation(ptr, usable);
+	}
 	return ptr;
 }
 
 void free(void* ptr) {
-	heap_status.size -= malloc_usable_size(ptr);
+	size_t usable = malloc_usable_size(ptr);
+	heap_status.size -= usable;
 	++heap_status.frees;
+	if (profiler_enabled) {
+		profile_free(ptr, usable);
+	}
 	emscripten_builtin_free(ptr);
 }
 
@@ -51,6 +294,14 @@ namespace screeps::cpu {
 	}
 } // namespace screeps::cpu
 
+static void* raw_malloc(size_t size) {
+	return emscripten_builtin_malloc(size);
+}
+
+static void raw_free(void* ptr) {
+	emscripten_builtin_free(ptr);
+}
+
 #elif __APPLE__
 #include <mach/mach.h>
 #include <malloc/malloc.h>
@@ -78,27 +329,40 @@ struct zone_malloc_overwrite_t {
 		zone_nest_guard_t nest;
 		void* ptr = default_malloc(zone, size);
 		if (nest.root && ptr != nullptr) {
-			heap_status.size += zone->size(zone, ptr);
+			size_t usable = zone->size(zone, ptr);
+			heap_status.size += usable;
 			++heap_status.allocs;
+			if (profiler_enabled) {
+				profile_allocation(ptr, usable);
+			}
 		}
 		return ptr;
 	}
 
 	static void* zone_realloc(malloc_zone_t* zone, void* ptr, size_t size) {
 		zone_nest_guard_t nest;
+		size_t old_size = 0;
 		if (nest.root && ptr != nullptr) {
+			old_size = zone->size(zone, ptr);
 			++heap_status.frees;
-			heap_status.size -= zone->size(zone, ptr);
+			heap_status.size -= old_size;
 		}
 		void* new_ptr = default_realloc(zone, ptr, size);
 		if (nest.root) {
 			if (new_ptr == nullptr) {
 				// `ptr` is still alive. very rare.
 				--heap_status.frees;
-				heap_status.size += zone->size(zone, ptr);
+				heap_status.size += old_size;
 			} else {
+				size_t usable = zone->size(zone, new_ptr);
 				++heap_status.allocs;
-				heap_status.size += zone->size(zone, new_ptr);
+				heap_status.size += usable;
+				if (profiler_enabled) {
+					if (ptr != nullptr) {
+						profile_free(ptr, old_size);
+					}
+					profile_allocation(new_ptr, usable);
+				}
 			}
 		}
 		return new_ptr;
@@ -107,8 +371,12 @@ struct zone_malloc_overwrite_t {
 	static void zone_free(malloc_zone_t* zone, void* ptr) {
 		zone_nest_guard_t nest;
 		if (nest.root) {
-			heap_status.size -= zone->size(zone, ptr);
+			size_t usable = zone->size(zone, ptr);
+			heap_status.size -= usable;
 			++heap_status.frees;
+			if (profiler_enabled) {
+				profile_free(ptr, usable);
+			}
 		}
 		default_free(zone, ptr);
 	}
@@ -119,6 +387,9 @@ struct zone_malloc_overwrite_t {
 			assert(zone->size(zone, ptr) == size);
 			heap_status.size -= size;
 			++heap_status.frees;
+			if (profiler_enabled) {
+				profile_free(ptr, size);
+			}
 		}
 		default_free_definite_size(zone, ptr, size);
 	}
@@ -151,4 +422,269 @@ struct zone_malloc_overwrite_t {
 };
 namespace { static zone_malloc_overwrite_t ctor; }
 
+// Nested inside a zone hook, so these aren't counted
+static void* raw_malloc(size_t size) {
+	return malloc(size);
+}
+
+static void raw_free(void* ptr) {
+	free(ptr);
+}
+
+#elif defined(__linux__) && defined(__GLIBC__)
+#include <malloc.h>
+#include <cerrno>
+// Native Linux builds replace the allocation functions and forward to glibc's own entry points,
+// which avoids bootstrapping through `dlsym`. Counters are updated atomically since tests and tools
+// may allocate from other threads.
+extern "C" {
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void* __libc_valloc(size_t size);
+extern void* __libc_pvalloc(size_t size);
+extern void __libc_free(void* ptr);
+
+static void* track_alloc(void* ptr) {
+	if (ptr != nullptr) {
+		size_t usable = malloc_usable_size(ptr);
+		__atomic_add_fetch(&heap_status.size, usable, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&heap_status.allocs, 1, __ATOMIC_RELAXED);
+		if (profiler_enabled) {
+			profile_allocation(ptr, usable);
+		}
+	}
+	return ptr;
+}
+
+static void track_free(void* ptr) {
+	if (ptr != nullptr) {
+		size_t usable = malloc_usable_size(ptr);
+		__atomic_sub_fetch(&heap_status.size, usable, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&heap_status.frees, 1, __ATOMIC_RELAXED);
+		if (profiler_enabled) {
+			profile_free(ptr, usable);
+		}
+	}
+}
+
+void* malloc(size_t size) {
+	return track_alloc(__libc_malloc(size));
+}
+
+void* calloc(size_t count, size_t size) {
+	return track_alloc(__libc_calloc(count, size));
+}
+
+void* realloc(void* ptr, size_t size) {
+	// Counted as a free and an allocation, like the macOS zone hooks. The old block's size has to be
+	// read before it's released; if reallocation fails it is still alive and nothing changes.
+	size_t old_size = ptr == nullptr ? 0 : malloc_usable_size(ptr);
+	void* new_ptr = __libc_realloc(ptr, size);
+	if (new_ptr == nullptr && size != 0) {
+		return nullptr;
+	}
+	if (ptr != nullptr) {
+		__atomic_sub_fetch(&heap_status.size, old_size, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&heap_status.frees, 1, __ATOMIC_RELAXED);
+		if (profiler_enabled) {
+			profile_free(ptr, old_size);
+		}
+	}
+	return track_alloc(new_ptr);
+}
+
+void* memalign(size_t alignment, size_t size) {
+	return track_alloc(__libc_memalign(alignment, size));
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+	return track_alloc(__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+	if (alignment == 0 || alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+		return EINVAL;
+	}
+	void* result = track_alloc(__libc_memalign(alignment, size));
+	if (result == nullptr) {
+		return ENOMEM;
+	}
+	*ptr = result;
+	return 0;
+}
+
+void* valloc(size_t size) {
+	return track_alloc(__libc_valloc(size));
+}
+
+void* pvalloc(size_t size) {
+	return track_alloc(__libc_pvalloc(size));
+}
+
+void free(void* ptr) {
+	track_free(ptr);
+	__libc_free(ptr);
+}
+
+}
+
+static void* raw_malloc(size_t size) {
+	return __libc_malloc(size);
+}
+
+static void raw_free(void* ptr) {
+	__libc_free(ptr);
+}
+
+#else
+// No allocator hooks, so the profiler never records anything
+static void* raw_malloc(size_t size) {
+	return std::malloc(size);
+}
+
+static void raw_free(void* ptr) {
+	std::free(ptr);
+}
+
 #endif
+
+//
+// Allocation profiler
+namespace {
+
+// Tags of live tagged blocks, keyed by address. Open addressing with linear probing and backward
+// shift deletion. Storage comes from `raw_malloc` so the table never reenters the hooks. Untagged
+// blocks are never inserted, so frees skip the lookup entirely while nothing tagged is alive.
+class tagged_blocks_t {
+	public:
+		void insert(void* ptr, uint8_t tag) {
+			if ((count + 1) * 2 > capacity) {
+				grow();
+				if ((count + 1) * 2 > capacity) {
+					return;
+				}
+			}
+			size_t ii = home(ptr);
+			while (entries[ii].ptr != nullptr) {
+				ii = (ii + 1) & (capacity - 1);
+			}
+			entries[ii] = {ptr, tag};
+			++count;
+		}
+
+		// Removes the block and returns its tag, or 0 if it wasn't tagged
+		int erase(void* ptr) {
+			if (count == 0) {
+				return 0;
+			}
+			size_t ii = home(ptr);
+			while (entries[ii].ptr != ptr) {
+				if (entries[ii].ptr == nullptr) {
+					return 0;
+				}
+				ii = (ii + 1) & (capacity - 1);
+			}
+			int tag = entries[ii].tag;
+			// Pull later entries of the probe sequence back into the hole
+			for (size_t jj = (ii + 1) & (capacity - 1); entries[jj].ptr != nullptr; jj = (jj + 1) & (capacity - 1)) {
+				size_t want = home(entries[jj].ptr);
+				if (((jj - want) & (capacity - 1)) >= ((jj - ii) & (capacity - 1))) {
+					entries[ii] = entries[jj];
+					ii = jj;
+				}
+			}
+			entries[ii] = {nullptr, 0};
+			--count;
+			return tag;
+		}
+
+	private:
+		struct entry_t {
+			void* ptr;
+			uint8_t tag;
+		};
+		entry_t* entries = nullptr;
+		size_t capacity = 0;
+		size_t count = 0;
+
+		size_t home(void* ptr) const {
+			return ((reinterpret_cast<uintptr_t>(ptr) >> 3) * 2654435761u) & (capacity - 1);
+		}
+
+		void grow() {
+			size_t new_capacity = capacity == 0 ? 1024 : capacity * 2;
+			auto* new_entries = static_cast<entry_t*>(raw_malloc(new_capacity * sizeof(entry_t)));
+			if (new_entries == nullptr) {
+				return;
+			}
+			std::memset(new_entries, 0, new_capacity * sizeof(entry_t));
+			entry_t* old_entries = entries;
+			size_t old_capacity = capacity;
+			entries = new_entries;
+			capacity = new_capacity;
+			count = 0;
+			for (size_t ii = 0; ii < old_capacity; ++ii) {
+				if (old_entries[ii].ptr != nullptr) {
+					insert(old_entries[ii].ptr, old_entries[ii].tag);
+				}
+			}
+			raw_free(old_entries);
+		}
+};
+
+tagged_blocks_t tagged_blocks;
+std::atomic_flag profiler_lock = ATOMIC_FLAG_INIT;
+
+// Native test binaries may allocate from several threads
+struct profiler_guard_t {
+	profiler_guard_t() {
+		while (profiler_lock.test_and_set(std::memory_order_acquire)) {}
+	}
+	~profiler_guard_t() {
+		profiler_lock.clear(std::memory_order_release);
+	}
+};
+
+int size_class(size_t size) {
+	int ii = 0;
+	while (ii + 1 < screeps::cpu::allocation_profile_t::k_size_classes && (size_t{1} << ii) < size) {
+		++ii;
+	}
+	return ii;
+}
+
+void profile_allocation(void* ptr, size_t size) {
+	profiler_guard_t guard;
+	auto& profile = allocation_profile;
+	auto& counts = profile.size_classes[size_class(size)];
+	++counts.allocs;
+	counts.live_bytes += size;
+	auto& tag = profile.tags[current_tag].counts;
+	++tag.allocs;
+	tag.live_bytes += size;
+	if (current_tag != 0) {
+		tagged_blocks.insert(ptr, current_tag);
+	}
+	profile.tick.peak = std::max(profile.tick.peak, heap_status.size);
+	profile.tick.churn += size;
+	++profile.tick.allocs;
+}
+
+void profile_free(void* ptr, size_t size) {
+	if (ptr == nullptr) {
+		return;
+	}
+	profiler_guard_t guard;
+	auto& profile = allocation_profile;
+	auto& counts = profile.size_classes[size_class(size)];
+	++counts.frees;
+	counts.live_bytes -= size;
+	auto& tag = profile.tags[tagged_blocks.erase(ptr)].counts;
+	++tag.frees;
+	tag.live_bytes -= size;
+}
+
+} // namespace
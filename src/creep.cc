@@ -40,11 +40,13 @@ void creep_t::init() {
 	);
 }
 
-const std::vector<creep_active_bodypart_t> creep_t::get_active_bodyparts() const {
-	std::vector<creep_active_bodypart_t> parts;
-	parts.reserve(hits / 100);
-	int active_hits = hits;
-	for (auto& ii : body) {
+namespace {
+
+template <class Parts>
+void fill_active_bodyparts(const creep_t& creep, Parts& parts) {
+	parts.reserve(creep.hits / 100);
+	int active_hits = creep.hits;
+	for (auto& ii : creep.body) {
 		if (active_hits > 100) {
 			parts.emplace_back(ii, 100);
 			active_hits -= 100;
@@ -53,6 +55,19 @@ const std::vector<creep_active_bodypart_t> creep_t::get_active_bodyparts() const
 			break;
 		}
 	}
+}
+
+} // namespace
+
+const std::vector<creep_active_bodypart_t> creep_t::get_active_bodyparts() const {
+	std::vector<creep_active_bodypart_t> parts;
+	fill_active_bodyparts(*this, parts);
+	return parts;
+}
+
+arena_vector_t<creep_active_bodypart_t> creep_t::get_active_bodyparts(tick_arena_t& arena) const {
+	arena_vector_t<creep_active_bodypart_t> parts{arena_allocator_t<creep_active_bodypart_t>(arena)};
+	fill_active_bodyparts(*this, parts);
 	return parts;
 }
 
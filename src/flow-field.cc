@@ -0,0 +1,265 @@
+#include <screeps/flow-field.h>
+#include <screeps/terrain.h>
+#include "./path-cost.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace screeps {
+
+namespace {
+
+using detail::world_position_t;
+
+constexpr uint32_t k_unvisited = 0xffffffff;
+constexpr int k_cache_size = 32;
+
+struct open_t {
+	uint32_t distance;
+	int id;
+
+	// Inverted because `std::push_heap` builds a max-heap
+	bool operator<(const open_t& rhs) const {
+		return distance > rhs.distance;
+	}
+};
+
+// Copy of a room's cost matrix at the time a field was built. Matrices are compared by value
+// because callbacks commonly hand back the same pointer after modifying the matrix.
+struct matrix_snapshot_t {
+	room_location_t location;
+	bool blocked;
+	std::optional<cost_matrix_t> cost_matrix;
+
+	bool matches(room_location_t location, const cost_matrix_t* cost_matrix, bool blocked) const {
+		if (this->location != location || this->blocked != blocked) {
+			return false;
+		} else if (cost_matrix == nullptr) {
+			return !this->cost_matrix;
+		} else {
+			return this->cost_matrix && *this->cost_matrix == *cost_matrix;
+		}
+	}
+};
+
+struct cache_entry_t {
+	path_finder_t::goals_t goals;
+	int plain_cost;
+	int swamp_cost;
+	std::vector<matrix_snapshot_t> snapshots;
+	std::shared_ptr<const flow_field_t> field;
+};
+
+// Most recently used field is at the front
+static std::list<cache_entry_t> cached_fields;
+
+bool same_goals(const path_finder_t::goals_t& left, const path_finder_t::goals_t& right) {
+	return std::equal(
+		left.begin(), left.end(), right.begin(), right.end(),
+		[](const path_finder_t::goal_t& left, const path_finder_t::goal_t& right) {
+			return left.pos == right.pos && left.range == right.range;
+		}
+	);
+}
+
+} // namespace
+
+flow_field_t::flow_field_t(const path_finder_t::goals_t& goals, const std::vector<room_location_t>& rooms, const path_finder_t::options_t& options) {
+	std::vector<room_location_t> open_rooms;
+	std::vector<const cost_matrix_t*> cost_matrices;
+	for (auto location : rooms) {
+		const cost_matrix_t* cost_matrix = nullptr;
+		if (options.room_callback) {
+			cost_matrix = options.room_callback(location);
+			if (cost_matrix == nullptr) {
+				continue;
+			}
+		}
+		open_rooms.push_back(location);
+		cost_matrices.push_back(cost_matrix);
+	}
+	*this = flow_field_t(goals, open_rooms, cost_matrices, options);
+}
+
+flow_field_t::flow_field_t(const path_finder_t::goals_t& goals, const std::vector<room_location_t>& rooms, const std::vector<const cost_matrix_t*>& cost_matrices, const path_finder_t::options_t& options) {
+	// Nodes are identified by `room * 2500 + xx * 50 + yy`, where `room` is the index in `rooms`
+	std::vector<std::shared_ptr<terrain_t>> terrain;
+	terrain.reserve(rooms.size());
+	this->rooms.resize(rooms.size());
+	for (size_t ii = 0; ii < rooms.size(); ++ii) {
+		terrain.push_back(terrain_t::load(rooms[ii]));
+		this->rooms[ii].location = rooms[ii];
+		this->rooms[ii].distances.fill(k_unreachable);
+		this->rooms[ii].directions.fill(direction_t::top);
+	}
+	auto room_index = [&](room_location_t location) {
+		auto ii = std::find(rooms.begin(), rooms.end(), location);
+		return ii == rooms.end() ? -1 : static_cast<int>(ii - rooms.begin());
+	};
+	auto cost = [&](int id) {
+		return internal::tile_cost(*terrain[id / 2500], cost_matrices[id / 2500], id % 2500, options);
+	};
+
+	std::vector<uint32_t> distances(rooms.size() * 2500, k_unvisited);
+	std::vector<bool> closed(rooms.size() * 2500, false);
+	std::vector<open_t> open_list;
+
+	// Every tile in range of a goal is a source. Impassable tiles get a distance and direction so that
+	// a creep standing on one can still find its way, but the search never expands through them.
+	for (auto& goal : goals) {
+		int range = std::max(goal.range, 0);
+		world_position_t center(goal.pos);
+		for (int dx = -range; dx <= range; ++dx) {
+			for (int dy = -range; dy <= range; ++dy) {
+				world_position_t pos(center.xx + dx, center.yy + dy);
+				int room = room_index(pos.location());
+				if (room == -1) {
+					continue;
+				}
+				int id = room * 2500 + (pos.xx % 50) * 50 + pos.yy % 50;
+				if (distances[id] != 0) {
+					distances[id] = 0;
+					open_list.push_back({0, id});
+				}
+			}
+		}
+	}
+	std::make_heap(open_list.begin(), open_list.end());
+
+	// Walk outward from the goals. Stepping from a neighbor onto `current` costs `current`'s tile cost,
+	// and the neighbor's direction points back at `current`.
+	while (!open_list.empty()) {
+		std::pop_heap(open_list.begin(), open_list.end());
+		open_t current = open_list.back();
+		open_list.pop_back();
+		if (closed[current.id]) {
+			continue;
+		}
+		closed[current.id] = true;
+		uint32_t current_cost = cost(current.id);
+		if (current_cost >= internal::k_obstacle_cost) {
+			continue;
+		}
+		uint32_t next_distance = current.distance + current_cost;
+
+		room_location_t location = rooms[current.id / 2500];
+		int index = current.id % 2500;
+		world_position_t pos(position_t(location, index / 50, index % 50));
+		// Same rules as the native path finder; creeps on an exit tile can only step back into the room
+		// or across the exit. These rules are symmetric so they also work walking backwards from goals.
+		auto neighbors = detail::world_neighbor_table[detail::edge_class(index)];
+		for (auto ii = neighbors.first; ii != neighbors.second; ++ii) {
+			world_position_t neighbor = pos.in_direction(*ii);
+			int room = neighbor.location() == location ? current.id / 2500 : room_index(neighbor.location());
+			if (room == -1) {
+				continue;
+			}
+			int id = room * 2500 + (neighbor.xx % 50) * 50 + neighbor.yy % 50;
+			if (closed[id] || next_distance >= distances[id]) {
+				continue;
+			}
+			distances[id] = next_distance;
+			this->rooms[room].directions[id % 2500] = *ii + 4;
+			open_list.push_back({next_distance, id});
+			std::push_heap(open_list.begin(), open_list.end());
+		}
+	}
+
+	for (size_t ii = 0; ii < distances.size(); ++ii) {
+		if (distances[ii] != k_unvisited) {
+			this->rooms[ii / 2500].distances[ii % 2500] = std::min<uint32_t>(distances[ii], k_unreachable - 1);
+		}
+	}
+}
+
+std::optional<direction_t> flow_field_t::direction(position_t pos) const {
+	auto field = room(pos.room);
+	if (field == nullptr) {
+		return std::nullopt;
+	}
+	int distance = field->distances.get(pos.xx, pos.yy);
+	if (distance == 0 || distance == k_unreachable) {
+		return std::nullopt;
+	}
+	return field->directions.get(pos.xx, pos.yy);
+}
+
+int flow_field_t::distance(position_t pos) const {
+	auto field = room(pos.room);
+	return field == nullptr ? k_unreachable : field->distances.get(pos.xx, pos.yy);
+}
+
+const flow_field_t::room_field_t* flow_field_t::room(room_location_t location) const {
+	for (auto& field : rooms) {
+		if (field.location == location) {
+			return &field;
+		}
+	}
+	return nullptr;
+}
+
+std::shared_ptr<const flow_field_t> flow_field_t::load(const path_finder_t::goals_t& goals, const std::vector<room_location_t>& rooms, const path_finder_t::options_t& options) {
+	// Resolve cost matrices first since they decide whether a cached field is still valid
+	std::vector<const cost_matrix_t*> resolved(rooms.size(), nullptr);
+	if (options.room_callback) {
+		for (size_t ii = 0; ii < rooms.size(); ++ii) {
+			resolved[ii] = options.room_callback(rooms[ii]);
+		}
+	}
+	auto is_blocked = [&](size_t ii) {
+		return options.room_callback && resolved[ii] == nullptr;
+	};
+
+	for (auto entry = cached_fields.begin(); entry != cached_fields.end(); ++entry) {
+		if (
+			entry->plain_cost != options.plain_cost ||
+			entry->swamp_cost != options.swamp_cost ||
+			entry->snapshots.size() != rooms.size() ||
+			!same_goals(entry->goals, goals)
+		) {
+			continue;
+		}
+		bool valid = true;
+		for (size_t ii = 0; ii < rooms.size() && valid; ++ii) {
+			valid = entry->snapshots[ii].matches(rooms[ii], resolved[ii], is_blocked(ii));
+		}
+		if (valid) {
+			cached_fields.splice(cached_fields.begin(), cached_fields, entry);
+			return entry->field;
+		}
+		// Same query with changed costs, this field will never be hit again
+		cached_fields.erase(entry);
+		break;
+	}
+
+	cache_entry_t entry{goals, options.plain_cost, options.swamp_cost, {}, nullptr};
+	std::vector<room_location_t> open_rooms;
+	std::vector<const cost_matrix_t*> cost_matrices;
+	entry.snapshots.reserve(rooms.size());
+	for (size_t ii = 0; ii < rooms.size(); ++ii) {
+		auto& snapshot = entry.snapshots.emplace_back(matrix_snapshot_t{rooms[ii], is_blocked(ii), std::nullopt});
+		if (resolved[ii] != nullptr) {
+			snapshot.cost_matrix = *resolved[ii];
+		}
+		if (!snapshot.blocked) {
+			open_rooms.push_back(rooms[ii]);
+			cost_matrices.push_back(resolved[ii]);
+		}
+	}
+	entry.field = std::shared_ptr<const flow_field_t>(new flow_field_t(goals, open_rooms, cost_matrices, options));
+	cached_fields.push_front(std::move(entry));
+	if (static_cast<int>(cached_fields.size()) > k_cache_size) {
+		cached_fields.pop_back();
+	}
+	return cached_fields.front().field;
+}
+
+void flow_field_t::flush() {
+	cached_fields.clear();
+}
+
+} // namespace screeps
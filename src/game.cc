@@ -1,5 +1,10 @@
 #include <screeps/game.h>
+#include <screeps/arena.h>
+#include <screeps/cost-matrix-cache.h>
+#include <screeps/cpu.h>
+#include <screeps/intent.h>
 #include <algorithm>
+#include <cstring>
 #include "./javascript.h"
 
 namespace screeps {
@@ -29,6 +34,7 @@ void game_state_t::init_layout() {
 	);
 	creep_t::init();
 	flag_t::init();
+	intent_queue_t::init();
 	room_t::init();
 	structure_t::init();
 }
@@ -54,11 +60,70 @@ void game_state_t::ensure_capacity(game_state_t* game) {
 	game->flags_memory.ensure_capacity(game->flags);
 }
 
+// JS has written how many objects of each type every room needs. Each room gets a slice of the
+// shared container, which only reallocates when the total outgrows it.
+EMSCRIPTEN_KEEPALIVE
+void game_state_t::allocate_rooms(game_state_t* game) {
+	game->allocate_room_objects(game->creeps, game->creeps_memory, &room_t::creeps_memory);
+	game->allocate_room_objects(game->dropped_resources, game->dropped_resources_memory, &room_t::dropped_resources_memory);
+	game->allocate_room_objects(game->sources, game->sources_memory, &room_t::sources_memory);
+	game->allocate_room_objects(game->structures, game->structures_memory, &room_t::structures_memory);
+	game->allocate_room_objects(game->tombstones, game->tombstones_memory, &room_t::tombstones_memory);
+}
+
+template <class Type>
+void game_state_t::allocate_room_objects(container_t<Type>& container, internal::memory_range_t<Type>& memory, internal::memory_range_t<Type> room_t::*range) {
+	uint32_t size = 0;
+	for (room_t* room : room_pointers) {
+		size += (room->*range).size;
+	}
+	if (size > memory.size) {
+		// Leave some room so that a slowly growing colony doesn't reallocate every tick
+		memory.size = size + size / 4;
+		memory.ensure_capacity(container);
+	}
+	Type* data = memory.data;
+	for (room_t* room : room_pointers) {
+		(room->*range).data = data;
+		data += (room->*range).size;
+	}
+}
+
+// Closes the gaps left by rooms which used less than they asked for (creeps reserve space for
+// spawning creeps), so each container holds only real objects and every room's are contiguous.
+template <class Type>
+void game_state_t::compact_room_objects(container_t<Type>& container, internal::memory_range_t<Type>& memory, internal::memory_range_t<Type> room_t::*range) {
+	Type* end = container.data();
+	for (room_t* room : room_pointers) {
+		auto& objects = room->*range;
+		if (objects.size != 0 && objects.data != end) {
+			// JS writes these as raw bytes anyway
+			std::memmove(static_cast<void*>(end), objects.data, objects.size * sizeof(Type));
+		}
+		objects.data = end;
+		end += objects.size;
+	}
+	memory.size = end - container.data();
+	memory.shrink(container);
+}
+
 void game_state_t::load() {
 
-	// Reset memory for flags and sites
+	// Temporaries from last tick are dead
+	tick_arena_t::get().reset();
+	intent_queue_t::get().reset();
+	cpu::begin_allocation_tick();
+	cpu::begin_cpu_profile_tick();
+	SCREEPS_PROFILE_ZONE("game_state_t::load");
+
+	// Reset memory for room objects, flags and sites
 	construction_sites_memory.reset(construction_sites);
+	creeps_memory.reset(creeps);
+	dropped_resources_memory.reset(dropped_resources);
 	flags_memory.reset(flags);
+	sources_memory.reset(sources);
+	structures_memory.reset(structures);
+	tombstones_memory.reset(tombstones);
 	for (auto& [location, room] : rooms) {
 		room.reset();
 	}
@@ -76,9 +141,15 @@ void game_state_t::load() {
 		Module.screeps.object.writeGame(Module, $0);
 	}, this);
 
-	// Shrink memory ranges
+	// Shrink memory ranges. Room objects are laid out over every room pointer, so they're compacted
+	// before the pointers shrink.
 	construction_sites_memory.shrink(construction_sites);
 	flags_memory.shrink(flags);
+	compact_room_objects(creeps, creeps_memory, &room_t::creeps_memory);
+	compact_room_objects(dropped_resources, dropped_resources_memory, &room_t::dropped_resources_memory);
+	compact_room_objects(sources, sources_memory, &room_t::sources_memory);
+	compact_room_objects(structures, structures_memory, &room_t::structures_memory);
+	compact_room_objects(tombstones, tombstones_memory, &room_t::tombstones_memory);
 	room_pointers_memory.shrink(room_pointers);
 
 	// Update room map keys
@@ -86,7 +157,6 @@ void game_state_t::load() {
 	int count = 0;
 	for (auto ii = rooms.begin(); ii != rooms.end(); ) {
 		if (++count > 10) throw std::runtime_error("uh oh");
-		ii->second.shrink();
 		if (ii->first == ii->second.location) {
 			ii->second.update_pointers();
 			++ii;
@@ -105,7 +175,6 @@ void game_state_t::load() {
 	}
 	for (auto ii = extra_rooms.begin(); ii != extra_rooms.end(); ) {
 		if (++count > 10) throw std::runtime_error("uh oh");
-		ii->second.shrink();
 		if (ii->second.location == room_location_t::null) {
 			++ii;
 		} else {
@@ -119,31 +188,37 @@ void game_state_t::load() {
 
 	// Finalize room state pointers
 	update_pointers();
+	cost_matrix_cache_t::update(*this);
 }
 
 void game_state_t::update_pointers() {
 	update_pointer_container<&room_t::construction_sites>(construction_sites);
+	update_pointer_container<&room_t::creeps>(creeps);
+	update_pointer_container<&room_t::dropped_resources>(dropped_resources);
 	update_pointer_container<&room_t::flags>(flags);
+	update_pointer_container<&room_t::sources>(sources);
+	update_pointer_container<&room_t::structures>(structures);
+	update_pointer_container<&room_t::tombstones>(tombstones);
+	for (auto& [location, room] : rooms) {
+		room.update_structure_pointers();
+	}
 }
 
 template <auto Property, class Container>
 void game_state_t::update_pointer_container(Container& container) {
-	typename Container::value_type* current = nullptr;
-	room_location_t current_location;
-	for (auto& object : container) {
-		auto location = object.pos.room;
-		if (current == nullptr) {
-			current = &object;
-			current_location = location;
-		}
-		if (&object == &container.back() || location != current_location) {
-			auto ii = rooms.find(object.pos.room);
-			if (ii != rooms.end()) {
-				auto& [location, room] = *ii;
-				room.*Property = {current, &object + 1};
-				current = nullptr;
-			}
+	// Objects are grouped by room, so each room's are one run
+	auto* first = container.data();
+	auto* end = first + container.size();
+	while (first != end) {
+		auto location = first->pos.room;
+		auto* last = std::find_if(first, end, [&](const auto& object) {
+			return object.pos.room != location;
+		});
+		auto ii = rooms.find(location);
+		if (ii != rooms.end()) {
+			ii->second.*Property = {first, last};
 		}
+		first = last;
 	}
 }
 
@@ -0,0 +1,234 @@
+#include <screeps/incremental-path.h>
+#include <screeps/terrain.h>
+#include "./path-cost.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace screeps {
+
+namespace {
+
+constexpr uint32_t k_infinity = 0xffffffff;
+
+constexpr uint32_t add(uint32_t left, uint32_t right) {
+	return left >= k_infinity - right ? k_infinity : left + right;
+}
+
+int local_index(position_t pos) {
+	return pos.xx * 50 + pos.yy;
+}
+
+} // namespace
+
+incremental_path_t::incremental_path_t(position_t origin, const path_finder_t::goals_t& goals, const cost_matrix_t& cost_matrix, const path_finder_t::options_t& options) :
+		room(origin.room),
+		start(local_index(origin)),
+		last_start(start),
+		// Cost matrix entries can be as low as 1 regardless of terrain costs
+		min_cost(std::clamp(std::min(options.plain_cost, options.swamp_cost), 0, 1)),
+		max_ops(options.max_ops),
+		terrain(terrain_t::load(origin.room)),
+		options(options),
+		cost_matrix(cost_matrix),
+		goals(false),
+		g(2500, k_infinity),
+		rhs(2500, k_infinity),
+		queued_keys(2500),
+		queued(2500, false) {
+	for (auto& goal : goals) {
+		if (goal.pos.room != room) {
+			continue;
+		}
+		int range = std::max(goal.range, 0);
+		for (int xx = std::max(goal.pos.xx - range, 0); xx <= std::min(goal.pos.xx + range, 49); ++xx) {
+			for (int yy = std::max(goal.pos.yy - range, 0); yy <= std::min(goal.pos.yy + range, 49); ++yy) {
+				int index = xx * 50 + yy;
+				this->goals[index] = true;
+				rhs[index] = 0;
+				push(index);
+			}
+		}
+	}
+}
+
+void incremental_path_t::move_to(position_t pos) {
+	if (pos.room != room) {
+		return;
+	}
+	// Keys already in the queue were computed from the old start, which is at most this much closer
+	last_start = start;
+	start = local_index(pos);
+	key_modifier = add(key_modifier, heuristic(last_start));
+}
+
+void incremental_path_t::update(const cost_matrix_t& cost_matrix) {
+	for (int index = 0; index < 2500; ++index) {
+		if (this->cost_matrix[index] != cost_matrix[index]) {
+			this->cost_matrix[index] = cost_matrix[index];
+			update_neighbors(index);
+		}
+	}
+}
+
+void incremental_path_t::set(local_position_t pos, uint8_t cost) {
+	int index = pos.xx * 50 + pos.yy;
+	if (cost_matrix[index] != cost) {
+		cost_matrix[index] = cost;
+		update_neighbors(index);
+	}
+}
+
+std::optional<direction_t> incremental_path_t::next_direction() {
+	auto next = next_index();
+	if (!next) {
+		return std::nullopt;
+	}
+	return local_position_t(start / 50, start % 50).direction_to(local_position_t(*next / 50, *next % 50));
+}
+
+path_finder_t::result_t incremental_path_t::path() {
+	path_finder_t::result_t result;
+	result.path = std::make_unique<path_finder_t::path_t>();
+	result.incomplete = !compute_shortest_path() || g[start] == k_infinity;
+	result.ops = ops;
+	result.cost = 0;
+	if (result.incomplete) {
+		return result;
+	}
+	result.cost = g[start];
+	int index = start;
+	while (!goals[index] && result.path->size() < path_finder_t::path_t::capacity()) {
+		// Greedy descent on `g`, same as `next_index` without recomputing
+		int best = -1;
+		uint32_t best_cost = k_infinity;
+		for (auto neighbor : local_position_t(index / 50, index % 50).neighbors()) {
+			int next = neighbor.xx * 50 + neighbor.yy;
+			uint32_t total = add(cost(next), g[next]);
+			if (total < best_cost) {
+				best = next;
+				best_cost = total;
+			}
+		}
+		if (best == -1) {
+			result.incomplete = true;
+			break;
+		}
+		result.path->emplace_back(room, best / 50, best % 50);
+		index = best;
+	}
+	return result;
+}
+
+uint32_t incremental_path_t::cost(int index) const {
+	uint32_t cost = internal::tile_cost(*terrain, &cost_matrix, index, options);
+	return cost >= internal::k_obstacle_cost ? k_infinity : cost;
+}
+
+uint32_t incremental_path_t::heuristic(int index) const {
+	int range = std::max(std::abs(index / 50 - start / 50), std::abs(index % 50 - start % 50));
+	return range * min_cost;
+}
+
+incremental_path_t::key_t incremental_path_t::calculate_key(int index) const {
+	uint32_t value = std::min(g[index], rhs[index]);
+	return {add(add(value, heuristic(index)), key_modifier), value};
+}
+
+void incremental_path_t::push(int index) {
+	queued[index] = true;
+	queued_keys[index] = calculate_key(index);
+	open_list.push_back({queued_keys[index], index});
+	std::push_heap(open_list.begin(), open_list.end());
+}
+
+// Drops stale entries and returns the top of the queue, if any. Entries are stale when their vertex
+// was removed from the queue or pushed again with a different key.
+bool incremental_path_t::top(open_t& entry) {
+	while (!open_list.empty()) {
+		const open_t& front = open_list.front();
+		if (queued[front.index] && queued_keys[front.index] == front.key) {
+			entry = front;
+			return true;
+		}
+		std::pop_heap(open_list.begin(), open_list.end());
+		open_list.pop_back();
+	}
+	return false;
+}
+
+void incremental_path_t::update_vertex(int index) {
+	if (!goals[index]) {
+		uint32_t best = k_infinity;
+		for (auto neighbor : local_position_t(index / 50, index % 50).neighbors()) {
+			int next = neighbor.xx * 50 + neighbor.yy;
+			best = std::min(best, add(cost(next), g[next]));
+		}
+		rhs[index] = best;
+	}
+	queued[index] = false;
+	if (g[index] != rhs[index]) {
+		push(index);
+	}
+}
+
+// Changing a cell's cost changes the cost of every edge leading into it
+void incremental_path_t::update_neighbors(int index) {
+	for (auto neighbor : local_position_t(index / 50, index % 50).neighbors()) {
+		update_vertex(neighbor.xx * 50 + neighbor.yy);
+	}
+}
+
+// Returns false if `max_ops` ran out before the path to `start` was settled
+bool incremental_path_t::compute_shortest_path() {
+	ops = 0;
+	open_t current;
+	while (top(current) && (current.key < calculate_key(start) || rhs[start] != g[start])) {
+		if (ops >= max_ops) {
+			return false;
+		}
+		++ops;
+		++total;
+		std::pop_heap(open_list.begin(), open_list.end());
+		open_list.pop_back();
+		int index = current.index;
+		queued[index] = false;
+		key_t key = calculate_key(index);
+		if (current.key < key) {
+			push(index);
+		} else if (g[index] > rhs[index]) {
+			g[index] = rhs[index];
+			for (auto neighbor : local_position_t(index / 50, index % 50).neighbors()) {
+				update_vertex(neighbor.xx * 50 + neighbor.yy);
+			}
+		} else {
+			g[index] = k_infinity;
+			update_vertex(index);
+			for (auto neighbor : local_position_t(index / 50, index % 50).neighbors()) {
+				update_vertex(neighbor.xx * 50 + neighbor.yy);
+			}
+		}
+	}
+	return true;
+}
+
+std::optional<int> incremental_path_t::next_index() {
+	if (goals[start] || !compute_shortest_path() || g[start] == k_infinity) {
+		return std::nullopt;
+	}
+	int best = -1;
+	uint32_t best_cost = k_infinity;
+	for (auto neighbor : local_position_t(start / 50, start % 50).neighbors()) {
+		int next = neighbor.xx * 50 + neighbor.yy;
+		uint32_t total = add(cost(next), g[next]);
+		if (total < best_cost) {
+			best = next;
+			best_cost = total;
+		}
+	}
+	if (best == -1) {
+		return std::nullopt;
+	}
+	return best;
+}
+
+} // namespace screeps
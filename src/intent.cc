@@ -0,0 +1,193 @@
+#include <screeps/intent.h>
+#include "./javascript.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace screeps {
+
+void intent_queue_t::init() {
+	EM_ASM({
+		Module.screeps.intent.initIntentLayout({
+			'sizeof': $0,
+			'object': $1,
+			'target': $2,
+			'result': $3,
+			'argument': $4,
+			'amount': $5,
+			'name': $6,
+			'nameLength': $7,
+			'pos': $8,
+			'kind': $9,
+		});
+	},
+		sizeof(record_t),
+		offsetof(record_t, object),
+		offsetof(record_t, target),
+		offsetof(record_t, result),
+		offsetof(record_t, argument),
+		offsetof(record_t, amount),
+		offsetof(record_t, name),
+		offsetof(record_t, name_length),
+		offsetof(record_t, pos),
+		offsetof(record_t, kind)
+	);
+}
+
+intent_queue_t& intent_queue_t::get() {
+	static intent_queue_t queue;
+	return queue;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void intent_queue_t::flush_tick() {
+	get().flush();
+}
+
+void intent_queue_t::reset() {
+	// Only happens if the last `loop()` threw before its intents went out
+	if (pending() != 0) {
+		std::cerr <<"intent_queue_t: dropped " <<pending() <<" intents from the last tick\n";
+	}
+	records.clear();
+	callbacks.clear();
+	bodies.clear();
+	names.clear();
+	flushed = 0;
+	next_callback = 0;
+	++generation;
+}
+
+intent_queue_t::record_t& intent_queue_t::push(kind_t kind, const sid_t& object, callback_t& callback) {
+	if (callback) {
+		callbacks.emplace_back(records.size(), std::move(callback));
+	}
+	auto& record = records.emplace_back();
+	record.object = object;
+	record.result = k_ok;
+	record.name_length = 0;
+	record.kind = kind;
+	return record;
+}
+
+void intent_queue_t::push_name(record_t& record, const std::string& name) {
+	record.name = names.size();
+	record.name_length = name.size();
+	names += name;
+}
+
+intent_queue_t::intent_t intent_queue_t::build(const creep_t& creep, const game_object_t& target, callback_t callback) {
+	push(kind_t::build, creep.id, callback).target = target.id;
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::drop(const creep_t& creep, resource_t resource, int amount, callback_t callback) {
+	auto& record = push(kind_t::drop, creep.id, callback);
+	record.argument = static_cast<int32_t>(resource);
+	record.amount = amount;
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::harvest(const creep_t& creep, const game_object_t& target, callback_t callback) {
+	push(kind_t::harvest, creep.id, callback).target = target.id;
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::move(const creep_t& creep, direction_t direction, callback_t callback) {
+	push(kind_t::move, creep.id, callback).argument = static_cast<int32_t>(direction);
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::pickup(const creep_t& creep, const game_object_t& target, callback_t callback) {
+	push(kind_t::pickup, creep.id, callback).target = target.id;
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::repair(const creep_t& creep, const game_object_t& target, callback_t callback) {
+	push(kind_t::repair, creep.id, callback).target = target.id;
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::suicide(const creep_t& creep, callback_t callback) {
+	push(kind_t::suicide, creep.id, callback);
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::transfer(const creep_t& creep, const game_object_t& target, resource_t resource, int amount, callback_t callback) {
+	auto& record = push(kind_t::transfer, creep.id, callback);
+	record.target = target.id;
+	record.argument = static_cast<int32_t>(resource);
+	record.amount = amount;
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::upgrade_controller(const creep_t& creep, const game_object_t& target, callback_t callback) {
+	push(kind_t::upgrade_controller, creep.id, callback).target = target.id;
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::withdraw(const creep_t& creep, const game_object_t& target, resource_t resource, int amount, callback_t callback) {
+	auto& record = push(kind_t::withdraw, creep.id, callback);
+	record.target = target.id;
+	record.argument = static_cast<int32_t>(resource);
+	record.amount = amount;
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::spawn_creep(const spawn_t& spawn, const spawn_t::body_t& body, const std::string& name, const spawn_t::options_t& options, callback_t callback) {
+	auto& record = push(kind_t::spawn_creep, spawn.id, callback);
+	record.argument = internal::js_handle_t::get_ref(body);
+	record.amount = options.directions.bits;
+	push_name(record, name);
+	bodies.push_back(body);
+	return last();
+}
+
+intent_queue_t::intent_t intent_queue_t::create_construction_site(position_t pos, structure_t::type_t structure_type, const std::string& name, callback_t callback) {
+	auto& record = push(kind_t::create_construction_site, {}, callback);
+	record.argument = structure_type;
+	record.pos = pos;
+	push_name(record, name);
+	return last();
+}
+
+void intent_queue_t::flush() {
+	size_t end = records.size();
+	if (flushed == end) {
+		return;
+	}
+#ifdef JAVASCRIPT
+	EM_ASM({
+		Module.screeps.intent.flush(Module, $0, $1, $2);
+	}, records.data() + flushed, records.data() + end, names.data());
+#else
+	for (size_t ii = flushed; ii < end; ++ii) {
+		const auto& record = records[ii];
+		if (record.kind == kind_t::create_construction_site) {
+			std::cerr <<record.pos <<".create_construction_site(" <<record.argument <<")\n";
+		} else {
+			std::cerr <<record.object <<".intent(" <<static_cast<int>(record.kind) <<", " <<record.argument <<", " <<record.amount <<")\n";
+		}
+	}
+#endif
+	flushed = end;
+
+	// Callbacks may queue more intents, which aren't flushed yet
+	while (next_callback < callbacks.size() && static_cast<size_t>(callbacks[next_callback].first) < flushed) {
+		auto callback = std::move(callbacks[next_callback].second);
+		int result = records[callbacks[next_callback].first].result;
+		++next_callback;
+		callback(result);
+	}
+}
+
+int intent_queue_t::result(intent_t intent) {
+	if (intent.generation != generation || intent.index < 0 || static_cast<size_t>(intent.index) >= records.size()) {
+		throw std::range_error("intent_queue_t::result");
+	}
+	if (static_cast<size_t>(intent.index) >= flushed) {
+		flush();
+	}
+	return records[intent.index].result;
+}
+
+} // namespace screeps
@@ -0,0 +1,98 @@
+#include <screeps/job.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace screeps {
+
+int job_queue_t::add(int id, uint16_t kind, int priority, std::unique_ptr<job_t> job) {
+	job_t* ptr = job.get();
+	int task = scheduler.add(priority, [this, id, ptr]() {
+		bool finished = ptr->step();
+		if (finished) {
+			entries.erase(std::find_if(entries.begin(), entries.end(), [&](const entry_t& entry) {
+				return entry.id == id;
+			}));
+		}
+		return finished;
+	});
+	entries.push_back({id, task, priority, kind, std::move(job)});
+	return id;
+}
+
+bool job_queue_t::cancel(int id) {
+	auto ii = std::find_if(entries.begin(), entries.end(), [&](const entry_t& entry) {
+		return entry.id == id;
+	});
+	if (ii == entries.end()) {
+		return false;
+	}
+	scheduler.cancel(ii->task);
+	entries.erase(ii);
+	return true;
+}
+
+void job_queue_t::clear() {
+	for (auto& entry : entries) {
+		scheduler.cancel(entry.task);
+	}
+	entries.clear();
+}
+
+bool job_queue_t::restore(const raw_memory_t& memory) {
+	memory_reader_t reader(k_checkpoint_size);
+	if (!memory.load(reader, segment)) {
+		clear();
+		return false;
+	}
+	return read(reader);
+}
+
+bool job_queue_t::checkpoint(const raw_memory_t& memory) {
+	memory_writer_t writer(k_checkpoint_size, k_version);
+	try {
+		write(writer);
+	} catch (const std::range_error&) {
+		return false;
+	}
+	return memory.save(writer, segment);
+}
+
+void job_queue_t::write(memory_writer_t& writer) {
+	int32_t count = entries.size();
+	writer <<next_id <<count;
+	for (auto& entry : entries) {
+		writer <<entry.id <<static_cast<int32_t>(entry.kind) <<entry.priority;
+		entry.job->write(writer);
+	}
+}
+
+bool job_queue_t::read(memory_reader_t& reader) {
+	clear();
+	if (reader.version() != k_version) {
+		return false;
+	}
+	try {
+		int32_t count;
+		reader >>next_id >>count;
+		for (int ii = 0; ii < count; ++ii) {
+			int id;
+			int32_t kind;
+			int priority;
+			reader >>id >>kind >>priority;
+			auto factory = factories.find(kind);
+			if (factory == factories.end()) {
+				clear();
+				return false;
+			}
+			auto job = factory->second();
+			job->read(reader);
+			add(id, kind, priority, std::move(job));
+		}
+	} catch (const std::range_error&) {
+		clear();
+		return false;
+	}
+	return true;
+}
+
+} // namespace screeps
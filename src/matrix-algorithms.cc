@@ -0,0 +1,98 @@
+#include <screeps/matrix-algorithms.h>
+#include <algorithm>
+
+namespace screeps::matrix_algorithms {
+
+distance_matrix_t bfs_distance(const std::vector<local_position_t>& sources, const local_matrix_t<bool>& passable, int max_distance) {
+	distance_matrix_t distances(k_unreachable);
+	// Every tile is queued at most once, so a flat array works as the queue
+	std::array<uint16_t, 2500> queue;
+	int head = 0;
+	int tail = 0;
+	for (auto pos : sources) {
+		int index = pos.xx * 50 + pos.yy;
+		if (distances[index] != 0) {
+			distances[index] = 0;
+			queue[tail++] = index;
+		}
+	}
+	max_distance = std::min<int>(max_distance, k_unreachable - 1);
+	while (head != tail) {
+		int index = queue[head++];
+		int distance = distances[index] + 1;
+		if (distance > max_distance) {
+			break;
+		}
+		for_each_neighbor(index, [&](int next) {
+			if (distances[next] == k_unreachable && passable[next]) {
+				distances[next] = distance;
+				queue[tail++] = next;
+			}
+		});
+	}
+	return distances;
+}
+
+int connected_components(const local_matrix_t<bool>& mask, label_matrix_t& labels) {
+	labels.fill(0);
+	std::array<uint16_t, 2500> stack;
+	int count = 0;
+	for (int start = 0; start < 2500; ++start) {
+		if (!mask[start] || labels[start] != 0) {
+			continue;
+		}
+		labels[start] = ++count;
+		int size = 0;
+		stack[size++] = start;
+		while (size != 0) {
+			int index = stack[--size];
+			for_each_neighbor(index, [&](int next) {
+				if (mask[next] && labels[next] == 0) {
+					labels[next] = count;
+					stack[size++] = next;
+				}
+			});
+		}
+	}
+	return count;
+}
+
+distance_matrix_t distance_transform(const local_matrix_t<bool>& mask, metric_t metric) {
+	distance_matrix_t distances;
+	bool diagonal = metric == metric_t::chebyshev;
+	// Neighbors outside the room are clear
+	auto at = [&](int xx, int yy) -> int {
+		return xx < 0 || xx > 49 || yy < 0 || yy > 49 ? 0 : distances[xx * 50 + yy];
+	};
+	// Forward pass looks at tiles before this one in index order, backward pass at tiles after it
+	for (int xx = 0; xx < 50; ++xx) {
+		for (int yy = 0; yy < 50; ++yy) {
+			int index = xx * 50 + yy;
+			if (!mask[index]) {
+				distances[index] = 0;
+				continue;
+			}
+			int nearest = std::min(at(xx - 1, yy), at(xx, yy - 1));
+			if (diagonal) {
+				nearest = std::min({nearest, at(xx - 1, yy - 1), at(xx - 1, yy + 1)});
+			}
+			distances[index] = std::min(nearest + 1, k_unreachable - 1);
+		}
+	}
+	for (int xx = 49; xx >= 0; --xx) {
+		for (int yy = 49; yy >= 0; --yy) {
+			int index = xx * 50 + yy;
+			if (distances[index] == 0) {
+				continue;
+			}
+			int nearest = std::min(at(xx + 1, yy), at(xx, yy + 1));
+			if (diagonal) {
+				nearest = std::min({nearest, at(xx + 1, yy + 1), at(xx + 1, yy - 1)});
+			}
+			distances[index] = std::min<int>(distances[index], nearest + 1);
+		}
+	}
+	return distances;
+}
+
+} // namespace screeps::matrix_algorithms
@@ -1,4 +1,5 @@
 #include <screeps/memory.h>
+#include <screeps/cpu.h>
 #include "./javascript.h"
 
 namespace screeps {
@@ -29,6 +30,7 @@ bool raw_memory_t::load(memory_reader_t& reader, int segment) const {
 }
 
 bool raw_memory_t::save(memory_writer_t& writer, int segment) const {
+	SCREEPS_PROFILE_ZONE("raw_memory_t::save");
 	// Can only save 10 segments per tick
 	if (segment != -1 && !saved_segments[segment]) {
 		if (count_saved >= k_memory_max_active_segments) {
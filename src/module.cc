@@ -1,5 +1,6 @@
 #include "./javascript.h"
 #include <screeps/game.h>
+#include <screeps/intent.h>
 #include <stdexcept>
 #include <typeinfo>
 
@@ -53,8 +54,18 @@ NAN_METHOD(mod_game_state_ensure_capacity) {
 	screeps::game_state_t::ensure_capacity(reinterpret_cast<screeps::game_state_t*>(Nan::To<int64_t>(info[0]).ToChecked()));
 }
 
-NAN_METHOD(mod_room_ensure_capacity) {
-	screeps::room_t::ensure_capacity(reinterpret_cast<screeps::room_t*>(Nan::To<int64_t>(info[0]).ToChecked()));
+NAN_METHOD(mod_game_state_allocate_rooms) {
+	screeps::game_state_t::allocate_rooms(reinterpret_cast<screeps::game_state_t*>(Nan::To<int64_t>(info[0]).ToChecked()));
+}
+
+NAN_METHOD(mod_intent_queue_flush_tick) {
+	Nan::TryCatch try_catch;
+	try {
+		screeps::intent_queue_t::flush_tick();
+	} catch (const screeps::js_error&) {
+		assert(try_catch.HasCaught());
+		try_catch.ReThrow();
+	}
 }
 
 NAN_METHOD(mod_loop) {
@@ -71,7 +82,8 @@ ISOLATED_VM_MODULE void InitForContext(Isolate* isolate, Local<Context> context,
 	Nan::SetMethod(target, "makeArrayBuffer", mod_make_array_buffer);
 	Nan::SetMethod(target, "__ZN7screeps12game_state_t11init_layoutEv", mod_game_state_init_layout);
 	Nan::SetMethod(target, "__ZN7screeps12game_state_t15ensure_capacityEPS0_", mod_game_state_ensure_capacity);
-	Nan::SetMethod(target, "__ZN7screeps6room_t15ensure_capacityEPS0_", mod_room_ensure_capacity);
+	Nan::SetMethod(target, "__ZN7screeps12game_state_t14allocate_roomsEPS0_", mod_game_state_allocate_rooms);
+	Nan::SetMethod(target, "__ZN7screeps14intent_queue_t10flush_tickEv", mod_intent_queue_flush_tick);
 	Nan::SetMethod(target, "__Z4loopv", mod_loop);
 }
 #endif
@@ -0,0 +1,176 @@
+#include <screeps/path-cache.h>
+#include <screeps/terrain.h>
+#include "./path-cost.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+
+namespace screeps {
+
+namespace {
+
+using detail::world_position_t;
+
+void hash_combine(size_t& seed, size_t value) {
+	seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+// Everything in `options_t` except `room_callback`
+size_t hash_options(const path_finder_t::options_t& options) {
+	size_t seed = 0;
+	hash_combine(seed, std::hash<int>()(options.plain_cost));
+	hash_combine(seed, std::hash<int>()(options.swamp_cost));
+	hash_combine(seed, std::hash<bool>()(options.flee));
+	hash_combine(seed, std::hash<int>()(options.max_ops));
+	hash_combine(seed, std::hash<int>()(options.max_rooms));
+	hash_combine(seed, std::hash<int>()(options.max_cost));
+	hash_combine(seed, std::hash<double>()(options.heuristic_weight));
+	hash_combine(seed, std::hash<int>()(static_cast<int>(options.engine)));
+	return seed;
+}
+
+bool same_goals(const path_finder_t::goals_t& left, const path_finder_t::goals_t& right) {
+	return std::equal(
+		left.begin(), left.end(), right.begin(), right.end(),
+		[](const path_finder_t::goal_t& left, const path_finder_t::goal_t& right) {
+			return left.pos == right.pos && left.range == right.range;
+		}
+	);
+}
+
+} // namespace
+
+path_finder_t::result_t path_cache_t::search(position_t origin, const path_finder_t::goals_t& goals, const path_finder_t::options_t& options) {
+	size_t options_hash = hash_options(options);
+	while (true) {
+		auto range = positions.equal_range(origin);
+		auto match = std::find_if(range.first, range.second, [&](const auto& ii) {
+			const entry_t& entry = *ii.second.first;
+			return entry.options_hash == options_hash && same_goals(entry.goals, goals);
+		});
+		if (match == range.second) {
+			break;
+		}
+		auto [entry, step] = match->second;
+		if (is_stale(*entry)) {
+			++statistics.invalidations;
+			erase(entry);
+			continue;
+		}
+
+		// Walk up to the starting point, then copy out the rest of the path
+		path_finder_t::result_t result;
+		result.path = std::make_unique<path_finder_t::path_t>();
+		result.ops = 0;
+		result.cost = 0;
+		result.incomplete = false;
+		world_position_t pos(entry->origin);
+		for (uint32_t ii = 0; ii < entry->length; ++ii) {
+			pos = pos.in_direction(entry->direction(ii));
+			if (ii >= step) {
+				result.path->emplace_back(pos);
+				result.cost += entry->costs[ii];
+			}
+		}
+		++(step == 0 ? statistics.hits : statistics.partial_hits);
+		entries.splice(entries.begin(), entries, entry);
+		return result;
+	}
+
+	++statistics.misses;
+	path_finder_t::result_t result = path_finder_t::search(origin, goals, options);
+	if (!result.incomplete) {
+		insert(origin, goals, options, options_hash, result);
+	}
+	return result;
+}
+
+void path_cache_t::invalidate(room_location_t room) {
+	++room_versions[room];
+}
+
+void path_cache_t::clear() {
+	entries.clear();
+	positions.clear();
+	statistics.size = 0;
+}
+
+bool path_cache_t::is_stale(const entry_t& entry) const {
+	return std::any_of(entry.versions.begin(), entry.versions.end(), [&](const auto& version) {
+		auto ii = room_versions.find(version.first);
+		return (ii == room_versions.end() ? 0 : ii->second) != version.second;
+	});
+}
+
+void path_cache_t::insert(position_t origin, const path_finder_t::goals_t& goals, const path_finder_t::options_t& options, size_t options_hash, const path_finder_t::result_t& result) {
+	entry_t entry{goals, options_hash, origin, result.path->size(), {}, {}, {}};
+	entry.directions.resize((entry.length + 1) >> 1);
+	entry.costs.reserve(entry.length);
+
+	// Cost matrices are loaded once per room on the path
+	room_location_t room = room_location_t::null;
+	std::shared_ptr<terrain_t> terrain;
+	const cost_matrix_t* cost_matrix = nullptr;
+	auto use_room = [&](room_location_t location) {
+		room = location;
+		auto ii = room_versions.find(room);
+		entry.versions.emplace_back(room, ii == room_versions.end() ? 0 : ii->second);
+		terrain = terrain_t::load(room);
+		cost_matrix = options.room_callback ? options.room_callback(room) : nullptr;
+	};
+	use_room(origin.room);
+
+	world_position_t previous(origin);
+	for (uint32_t ii = 0; ii < entry.length; ++ii) {
+		world_position_t pos((*result.path)[ii]);
+		if (std::max(
+			std::abs(static_cast<int>(pos.xx) - static_cast<int>(previous.xx)),
+			std::abs(static_cast<int>(pos.yy) - static_cast<int>(previous.yy))
+		) != 1) {
+			// Not a contiguous path, this can't be stored as directions
+			return;
+		}
+		entry.directions[ii >> 1] |= +previous.direction_to(pos) << ((ii & 1) << 2);
+		if (pos.location() != room) {
+			use_room(pos.location());
+		}
+		entry.costs.push_back(internal::tile_cost(*terrain, cost_matrix, (pos.xx % 50) * 50 + pos.yy % 50, options));
+		previous = pos;
+	}
+
+	entries.push_front(std::move(entry));
+	auto inserted = entries.begin();
+	world_position_t pos(origin);
+	positions.emplace(pos, std::make_pair(inserted, 0u));
+	for (uint32_t ii = 0; ii < inserted->length; ++ii) {
+		pos = pos.in_direction(inserted->direction(ii));
+		positions.emplace(pos, std::make_pair(inserted, ii + 1));
+	}
+	++statistics.size;
+
+	if (statistics.size > capacity) {
+		++statistics.evictions;
+		erase(std::prev(entries.end()));
+	}
+}
+
+void path_cache_t::erase(entry_iterator_t entry) {
+	world_position_t pos(entry->origin);
+	for (uint32_t ii = 0; ii <= entry->length; ++ii) {
+		if (ii > 0) {
+			pos = pos.in_direction(entry->direction(ii - 1));
+		}
+		auto range = positions.equal_range(pos);
+		for (auto jj = range.first; jj != range.second; ++jj) {
+			if (jj->second.first == entry) {
+				positions.erase(jj);
+				break;
+			}
+		}
+	}
+	entries.erase(entry);
+	--statistics.size;
+}
+
+} // namespace screeps
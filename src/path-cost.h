@@ -0,0 +1,30 @@
+#pragma once
+#include <screeps/path-finder.h>
+#include <screeps/terrain.h>
+#include <algorithm>
+#include <cstdint>
+
+namespace screeps::internal {
+
+constexpr uint32_t k_obstacle_cost = 0xff;
+
+// Cost of entering a tile, following the same rules as the game's PathFinder: nonzero cost matrix
+// entries override terrain, and anything 0xff or higher is impassable.
+inline uint32_t tile_cost(const terrain_t& terrain, const cost_matrix_t* cost_matrix, int index, const path_finder_t::options_t& options) {
+	if (cost_matrix != nullptr) {
+		uint32_t cost = (*cost_matrix)[index];
+		if (cost != 0) {
+			return cost;
+		}
+	}
+	uint8_t type = terrain[index];
+	if (type & terrain_t::wall) {
+		return k_obstacle_cost;
+	} else if (type & terrain_t::swamp) {
+		return std::min<uint32_t>(options.swamp_cost, k_obstacle_cost);
+	} else {
+		return std::min<uint32_t>(options.plain_cost, k_obstacle_cost);
+	}
+}
+
+} // namespace screeps::internal
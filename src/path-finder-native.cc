@@ -0,0 +1,449 @@
+#include <screeps/path-finder.h>
+#include <screeps/terrain.h>
+#include "./path-cost.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace screeps {
+
+namespace {
+
+using detail::world_position_t;
+
+// Same limits as the game's PathFinder
+constexpr int k_max_rooms = 64;
+constexpr uint32_t k_obstacle = internal::k_obstacle_cost;
+constexpr uint32_t k_unvisited = 0xffffffff;
+
+// Offsets for each `direction_t`, index 0 is unused
+constexpr int k_dx[] = {0, 0, 1, 1, 1, 0, -1, -1, -1};
+constexpr int k_dy[] = {0, -1, -1, 0, 1, 1, 1, 0, -1};
+
+// Search state for a single tile. Nodes are identified by `room * 2500 + xx * 50 + yy`, where `room`
+// is the room's index in the order rooms were first seen during this search. Nodes from previous
+// searches are detected by `generation` so the storage never has to be cleared.
+struct node_t {
+	uint32_t generation;
+	uint32_t g;
+	int parent;
+	bool closed;
+};
+
+struct open_t {
+	uint32_t f;
+	uint32_t h;
+	uint32_t g;
+	int id;
+
+	// Inverted because `std::push_heap` builds a max-heap. Ties go to the node closer to the goal.
+	bool operator<(const open_t& rhs) const {
+		return f == rhs.f ? h > rhs.h : f > rhs.f;
+	}
+};
+
+struct goal_t {
+	world_position_t pos;
+	uint32_t range;
+};
+
+struct room_info_t {
+	room_location_t location;
+	std::shared_ptr<terrain_t> terrain;
+	const cost_matrix_t* cost_matrix;
+};
+
+// Storage shared by all searches
+static std::vector<node_t> nodes;
+static std::vector<open_t> open_list;
+static std::vector<int> jump_points;
+static uint32_t generation = 0;
+
+// Exit tiles can't be moved along, which breaks the assumptions jump point search makes about which
+// neighbors can be pruned. Any tile next to an exit is treated as a jump point.
+constexpr bool is_near_border(int xx, int yy) {
+	return xx <= 1 || xx >= 48 || yy <= 1 || yy >= 48;
+}
+
+constexpr bool is_diagonal(direction_t direction) {
+	return +direction % 2 == 0;
+}
+
+class native_path_finder_t {
+	public:
+		native_path_finder_t(const path_finder_t::goals_t& goals, const path_finder_t::options_t& options) :
+				options(options),
+				max_rooms(std::min(options.max_rooms, k_max_rooms)),
+				max_cost(options.max_cost < 0 ? 0 : options.max_cost) {
+			this->goals.reserve(goals.size());
+			for (auto& goal : goals) {
+				this->goals.push_back({goal.pos, static_cast<uint32_t>(std::max(goal.range, 0))});
+			}
+			if (++generation == 0) {
+				// Generation counter wrapped, stale nodes could look fresh
+				nodes.clear();
+				generation = 1;
+			}
+			open_list.clear();
+		}
+
+		struct result_t {
+			int32_t ops = 0;
+			int32_t cost = 0;
+			bool incomplete = true;
+			// -1 if the path didn't fit
+			int length = 0;
+		};
+
+		// Writes the path into `path`, which has room for `capacity` positions
+		result_t search(position_t origin_position, position_t* path, int capacity) {
+			result_t result;
+
+			world_position_t origin(origin_position);
+			int origin_room = room_index(origin.location());
+			if (origin_room == -1) {
+				return result;
+			}
+			int origin_id = origin_room * 2500 + (origin.xx % 50) * 50 + origin.yy % 50;
+			uint32_t origin_h = heuristic(origin);
+			if (origin_h == 0) {
+				result.incomplete = false;
+				return result;
+			}
+			node(origin_id) = {generation, 0, -1, false};
+			open_list.push_back({weigh(0, origin_h), origin_h, 0, origin_id});
+
+			// Best incomplete path, in case no goal is reached
+			int best_id = origin_id;
+			uint32_t best_h = origin_h;
+			uint32_t best_g = 0;
+
+			while (!open_list.empty() && ops < options.max_ops) {
+				std::pop_heap(open_list.begin(), open_list.end());
+				open_t current = open_list.back();
+				open_list.pop_back();
+				node_t& current_node = nodes[current.id];
+				if (current_node.closed || current.g != current_node.g) {
+					// Stale entry for a node which was found again with a lower cost
+					continue;
+				}
+				current_node.closed = true;
+				++ops;
+
+				if (current.h == 0) {
+					best_id = current.id;
+					best_h = 0;
+					result.incomplete = false;
+					break;
+				} else if (current.h < best_h || (current.h == best_h && current.g < best_g)) {
+					best_id = current.id;
+					best_h = current.h;
+					best_g = current.g;
+				}
+
+				if (options.engine == path_finder_t::engine_t::jump_point) {
+					expand_jump_point(current.id, current.g);
+				} else {
+					expand_astar(current.id, current.g);
+				}
+			}
+
+			result.ops = ops;
+			result.cost = nodes[best_id].g;
+			result.length = write_path(path, capacity, best_id);
+			return result;
+		}
+
+	private:
+		const path_finder_t::options_t& options;
+		std::vector<goal_t> goals;
+		std::vector<room_info_t> rooms;
+		std::vector<room_location_t> blocked_rooms;
+		int max_rooms;
+		uint32_t max_cost;
+		int ops = 0;
+
+		// Returns the index of a room in `rooms`, loading it if needed, or -1 if it can't be entered
+		int room_index(room_location_t location) {
+			for (int ii = 0; ii < static_cast<int>(rooms.size()); ++ii) {
+				if (rooms[ii].location == location) {
+					return ii;
+				}
+			}
+			if (
+				static_cast<int>(rooms.size()) >= max_rooms ||
+				std::find(blocked_rooms.begin(), blocked_rooms.end(), location) != blocked_rooms.end()
+			) {
+				return -1;
+			}
+			const cost_matrix_t* cost_matrix = nullptr;
+			if (options.room_callback) {
+				// Same as returning `false` from `roomCallback` in JS
+				cost_matrix = options.room_callback(location);
+				if (cost_matrix == nullptr) {
+					blocked_rooms.push_back(location);
+					return -1;
+				}
+			}
+			rooms.push_back({location, terrain_t::load(location), cost_matrix});
+			size_t size = rooms.size() * 2500;
+			if (nodes.size() < size) {
+				nodes.resize(size, node_t{0, 0, -1, false});
+			}
+			return rooms.size() - 1;
+		}
+
+		uint32_t look(int room, int index) const {
+			return internal::tile_cost(*rooms[room].terrain, rooms[room].cost_matrix, index, options);
+		}
+
+		uint32_t heuristic(world_position_t pos) const {
+			auto range_to = [&](world_position_t goal) {
+				return std::max(
+					pos.xx > goal.xx ? pos.xx - goal.xx : goal.xx - pos.xx,
+					pos.yy > goal.yy ? pos.yy - goal.yy : goal.yy - pos.yy
+				);
+			};
+			if (options.flee) {
+				uint32_t ret = 0;
+				for (auto& goal : goals) {
+					uint32_t range = range_to(goal.pos);
+					if (range < goal.range) {
+						ret = std::max(ret, goal.range - range);
+					}
+				}
+				return ret;
+			} else {
+				uint32_t ret = k_unvisited;
+				for (auto& goal : goals) {
+					uint32_t range = range_to(goal.pos);
+					ret = std::min(ret, range > goal.range ? range - goal.range : 0);
+				}
+				return ret;
+			}
+		}
+
+		uint32_t weigh(uint32_t g, uint32_t h) const {
+			return g + static_cast<uint32_t>(h * options.heuristic_weight);
+		}
+
+		world_position_t position_of(int id) const {
+			room_location_t location = rooms[id / 2500].location;
+			int index = id % 2500;
+			return {(location.xx + 0x80) * 50u + index / 50, (location.yy + 0x80) * 50u + index % 50};
+		}
+
+		node_t& node(int id) {
+			node_t& node = nodes[id];
+			if (node.generation != generation) {
+				node = {generation, k_unvisited, -1, false};
+			}
+			return node;
+		}
+
+		void push(int id, int parent, uint32_t g, world_position_t pos) {
+			if (g > max_cost) {
+				return;
+			}
+			node_t& next = node(id);
+			if (next.closed || g >= next.g) {
+				return;
+			}
+			next.g = g;
+			next.parent = parent;
+			uint32_t h = heuristic(pos);
+			open_list.push_back({weigh(g, h), h, g, id});
+			std::push_heap(open_list.begin(), open_list.end());
+		}
+
+		// Plain A* expansion into every neighbor, crossing into other rooms as needed
+		void expand_astar(int id, uint32_t g) {
+			int room = id / 2500;
+			int index = id % 2500;
+			world_position_t pos = position_of(id);
+			// `world_neighbor_table` so creeps standing on an exit tile can only step back into the room
+			// or across the exit
+			auto [begin, end] = detail::world_neighbor_table[detail::edge_class(index)];
+			for (auto ii = begin; ii != end; ++ii) {
+				world_position_t next = pos.in_direction(*ii);
+				int next_room = room;
+				if (next.location() != rooms[room].location) {
+					next_room = room_index(next.location());
+					if (next_room == -1) {
+						continue;
+					}
+				}
+				int next_index = (next.xx % 50) * 50 + next.yy % 50;
+				uint32_t cost = look(next_room, next_index);
+				if (cost < k_obstacle) {
+					push(next_room * 2500 + next_index, id, g + cost, next);
+				}
+			}
+		}
+
+		// Jump point search. This only prunes neighbors of tiles where every neighbor has the same cost
+		// or is an obstacle. Tiles near exits or next to a cost change are always jump points and fall
+		// back to A* expansion, so mixed-cost areas are searched exactly like A*.
+		void expand_jump_point(int id, uint32_t g) {
+			int room = id / 2500;
+			int index = id % 2500;
+			int xx = index / 50;
+			int yy = index % 50;
+			int parent = nodes[id].parent;
+			uint32_t base = look(room, index);
+			if (parent == -1 || is_near_border(xx, yy) || !is_uniform(room, xx, yy, base)) {
+				expand_astar(id, g);
+				return;
+			}
+			direction_t direction = position_of(parent).direction_to(position_of(id));
+			auto try_jump = [&](direction_t direction) {
+				uint32_t cost = g;
+				int next_index = jump(room, xx, yy, direction, base, cost);
+				if (next_index != -1) {
+					push(room * 2500 + next_index, id, cost, position_of(room * 2500 + next_index));
+				}
+			};
+			try_jump(direction);
+			if (is_diagonal(direction)) {
+				try_jump(direction - 1);
+				try_jump(direction + 1);
+				if (is_forced(room, xx, yy, direction - 3, direction - 2)) {
+					try_jump(direction - 2);
+				}
+				if (is_forced(room, xx, yy, direction + 3, direction + 2)) {
+					try_jump(direction + 2);
+				}
+			} else {
+				if (is_forced(room, xx, yy, direction - 2, direction - 1)) {
+					try_jump(direction - 1);
+				}
+				if (is_forced(room, xx, yy, direction + 2, direction + 1)) {
+					try_jump(direction + 1);
+				}
+			}
+		}
+
+		// True if every neighbor of a tile is either an obstacle or has cost `base`. `xx` and `yy` must
+		// not be on the border.
+		bool is_uniform(int room, int xx, int yy, uint32_t base) const {
+			for (int dir = 1; dir <= 8; ++dir) {
+				uint32_t cost = look(room, (xx + k_dx[dir]) * 50 + yy + k_dy[dir]);
+				if (cost != base && cost < k_obstacle) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// A neighbor is forced if the tile beside the current direction of travel is an obstacle and the
+		// neighbor itself is passable. `xx` and `yy` must not be on the border.
+		bool is_forced(int room, int xx, int yy, direction_t side, direction_t neighbor) const {
+			return
+				look(room, (xx + k_dx[+side]) * 50 + yy + k_dy[+side]) >= k_obstacle &&
+				look(room, (xx + k_dx[+neighbor]) * 50 + yy + k_dy[+neighbor]) < k_obstacle;
+		}
+
+		bool has_forced_neighbor(int room, int xx, int yy, direction_t direction) const {
+			if (is_diagonal(direction)) {
+				return
+					is_forced(room, xx, yy, direction - 3, direction - 2) ||
+					is_forced(room, xx, yy, direction + 3, direction + 2);
+			} else {
+				return
+					is_forced(room, xx, yy, direction - 2, direction - 1) ||
+					is_forced(room, xx, yy, direction + 2, direction + 1);
+			}
+		}
+
+		// Walks in a straight line until reaching a jump point. Returns the local index of the jump
+		// point, or -1 if the walk ran into an obstacle. `cost` is incremented by the cost of each step.
+		int jump(int room, int xx, int yy, direction_t direction, uint32_t base, uint32_t& cost) const {
+			world_position_t origin = position_of(room * 2500);
+			while (true) {
+				xx += k_dx[+direction];
+				yy += k_dy[+direction];
+				int index = xx * 50 + yy;
+				uint32_t tile = look(room, index);
+				if (tile >= k_obstacle) {
+					return -1;
+				}
+				cost += tile;
+				if (cost > max_cost) {
+					return -1;
+				}
+				if (
+					tile != base || is_near_border(xx, yy) ||
+					heuristic({origin.xx + xx, origin.yy + yy}) == 0 ||
+					!is_uniform(room, xx, yy, base) ||
+					has_forced_neighbor(room, xx, yy, direction)
+				) {
+					return index;
+				}
+				if (is_diagonal(direction)) {
+					uint32_t first_probe = 0;
+					uint32_t second_probe = 0;
+					if (
+						jump(room, xx, yy, direction - 1, base, first_probe) != -1 ||
+						jump(room, xx, yy, direction + 1, base, second_probe) != -1
+					) {
+						return index;
+					}
+				}
+			}
+		}
+
+		// Writes the path from the origin to `id` and returns its length, or -1 if it's longer than
+		// `capacity`. Jump points are filled in with each tile in between.
+		int write_path(position_t* path, int capacity, int id) const {
+			int length = 0;
+			jump_points.clear();
+			for (int ii = id; ii != -1; ii = nodes[ii].parent) {
+				jump_points.push_back(ii);
+			}
+			for (auto ii = jump_points.rbegin(); ii + 1 < jump_points.rend(); ++ii) {
+				world_position_t pos = position_of(*ii);
+				world_position_t next = position_of(*(ii + 1));
+				while (pos.xx != next.xx || pos.yy != next.yy) {
+					if (length == capacity) {
+						return -1;
+					}
+					pos = pos.in_direction(pos.direction_to(next));
+					path[length++] = position_t(pos);
+				}
+			}
+			return length;
+		}
+};
+
+} // namespace
+
+path_finder_t::result_t path_finder_t::search_native(position_t origin, const goals_t& goals, const options_t& options) {
+	result_t result;
+	result.path = std::make_unique<path_t>();
+	auto native = native_path_finder_t(goals, options).search(origin, result.path->data(), result.path->capacity());
+	if (native.length == -1) {
+		throw std::range_error("path_finder_t::search_native");
+	}
+	result.path->resize(native.length);
+	result.ops = native.ops;
+	result.cost = native.cost;
+	result.incomplete = native.incomplete;
+	return result;
+}
+
+void path_finder_t::search_native(query_t& query, arena_t arena, const options_t& options) {
+	auto native = native_path_finder_t(query.goals, options).search(query.origin, arena.data(), arena.size());
+	query.ops = native.ops;
+	query.cost = native.cost;
+	if (native.length == -1) {
+		query.path = {arena.data(), arena.data()};
+		query.incomplete = true;
+	} else {
+		query.path = {arena.data(), arena.data() + native.length};
+		query.incomplete = native.incomplete;
+	}
+}
+
+} // namespace screeps
@@ -1,9 +1,27 @@
 #include <screeps/path-finder.h>
+#include <screeps/cpu.h>
 #include "./javascript.h"
+#include <algorithm>
+#include <unordered_map>
 
 namespace screeps {
 
+namespace {
+	// Per-query output of `search_many`, written by JS
+	struct batch_result_t {
+		int32_t offset;
+		int32_t length;
+		int32_t ops;
+		int32_t cost;
+		int32_t incomplete;
+	};
+}
+
 path_finder_t::result_t path_finder_t::search(const position_t origin, const std::vector<goal_t>& goals, const options_t& options) {
+	SCREEPS_PROFILE_ZONE("path_finder_t::search");
+	if (options.engine != engine_t::javascript) {
+		return search_native(origin, goals, options);
+	}
 	result_t result;
 	result.path = std::make_unique<path_t>();
 	EM_ASM({
@@ -12,7 +30,7 @@ path_finder_t::result_t path_finder_t::search(const position_t origin, const std
 			var tmp = Object.create(PathFinder.CostMatrix.prototype);
 			roomCallback = function(roomName) {
 				var room = Module.screeps.position.parseRoomName(roomName);
-				var ptr = Module.__ZN7screeps13path_finder_t19callback_trampolineEPvii($10, room.rx, room.ry);
+				var ptr = Module.__ZN7screeps13path_finder_t19callback_trampolineEPvii($10, room & 0xff, room >> 8);
 				if (ptr === 0) {
 					return false;
 				} else {
@@ -23,7 +41,7 @@ path_finder_t::result_t path_finder_t::search(const position_t origin, const std
 		}
 		var result = PathFinder.search(
 			Module.screeps.position.read(Module, $0),
-			Module.screeps.vector.map(Module, $1, $2, 4, function(env, ptr) {
+			Module.screeps.vector.map(Module, $1, $2, 8, function(env, ptr) {
 				return { pos: Module.screeps.position.read(env, ptr), range: env.readInt32(ptr + 4) };
 			}),
 			{
@@ -55,6 +73,120 @@ path_finder_t::result_t path_finder_t::search(const position_t origin, const std
 	return result;
 }
 
+void path_finder_t::search_many(pointer_container_t<query_t> queries, arena_t arena, const options_t& options) {
+	// Cost matrices are shared by every query in the batch
+	std::unordered_map<room_location_t, const cost_matrix_t*> cost_matrices;
+	options_t shared_options = options;
+	if (options.room_callback) {
+		shared_options.room_callback = [&](room_location_t room) {
+			auto ii = cost_matrices.find(room);
+			if (ii == cost_matrices.end()) {
+				ii = cost_matrices.emplace(room, options.room_callback(room)).first;
+			}
+			return ii->second;
+		};
+	}
+
+	if (options.engine != engine_t::javascript) {
+		// Each path is written straight into the rest of the arena
+		position_t* used = arena.data();
+		for (auto& query : queries) {
+			search_native(query, {used, arena.end()}, shared_options);
+			used = query.path.end();
+		}
+		return;
+	}
+
+	// Flatten queries so JS only has to walk plain arrays
+	std::vector<position_t> origins;
+	std::vector<int32_t> goal_offsets;
+	std::vector<goal_t> goals;
+	origins.reserve(queries.size());
+	goal_offsets.reserve(queries.size() + 1);
+	for (auto& query : queries) {
+		origins.push_back(query.origin);
+		goal_offsets.push_back(goals.size());
+		goals.insert(goals.end(), query.goals.begin(), query.goals.end());
+	}
+	goal_offsets.push_back(goals.size());
+	std::vector<batch_result_t> results(queries.size());
+
+	EM_ASM({
+		var roomCallback;
+		if ($11) {
+			var matrices = Object.create(null);
+			roomCallback = function(roomName) {
+				var matrix = matrices[roomName];
+				if (matrix === undefined) {
+					var room = Module.screeps.position.parseRoomName(roomName);
+					var ptr = Module.__ZN7screeps13path_finder_t19callback_trampolineEPvii($11, room & 0xff, room >> 8);
+					if (ptr === 0) {
+						matrix = false;
+					} else {
+						matrix = Object.create(PathFinder.CostMatrix.prototype);
+						matrix._bits = new Uint8Array(Module.buffer, ptr, 2500);
+					}
+					matrices[roomName] = matrix;
+				}
+				return matrix;
+			};
+		}
+		var options = {
+			plainCost: $4,
+			swampCost: $5,
+			flee: $6,
+			maxOps: $7,
+			maxRooms: $8,
+			maxCost: $9,
+			heuristicWeight: $10,
+			roomCallback: roomCallback,
+		};
+		var used = 0;
+		for (var ii = 0; ii < $0; ++ii) {
+			var goals = Module.screeps.vector.map(
+				Module,
+				$3 + Module.readInt32($2 + ii * 4) * 8,
+				Module.readInt32($2 + ii * 4 + 4) - Module.readInt32($2 + ii * 4),
+				8,
+				function(env, ptr) {
+					return { pos: Module.screeps.position.read(env, ptr), range: env.readInt32(ptr + 4) };
+				}
+			);
+			var result = PathFinder.search(Module.screeps.position.read(Module, $1 + ii * 4), goals, options);
+			var fits = used + result.path.length <= $13;
+			var out = $14 + ii * 20;
+			Module.writeInt32(out, used);
+			Module.writeInt32(out + 4, fits ? result.path.length : 0);
+			Module.writeInt32(out + 8, result.ops);
+			Module.writeInt32(out + 12, result.cost);
+			Module.writeInt32(out + 16, result.incomplete || !fits);
+			if (fits) {
+				Module.screeps.array.writeData(Module, $12 + used * 4, 4, result.path, Module.screeps.position.write);
+				used += result.path.length;
+			}
+		}
+	},
+		queries.size(),
+		origins.data(), goal_offsets.data(), goals.data(),
+		options.plain_cost, options.swamp_cost,
+		options.flee,
+		options.max_ops, options.max_rooms, options.max_cost,
+		options.heuristic_weight,
+		options.room_callback ? &shared_options : nullptr,
+		arena.data(), arena.size(),
+		results.data()
+	);
+
+	for (size_t ii = 0; ii < queries.size(); ++ii) {
+		auto& result = results[ii];
+		auto& query = queries[ii];
+		query.path = {arena.data() + result.offset, arena.data() + result.offset + result.length};
+		query.ops = result.ops;
+		query.cost = result.cost;
+		query.incomplete = result.incomplete != 0;
+	}
+}
+
 EMSCRIPTEN_KEEPALIVE
 const void* path_finder_t::callback_trampoline(void* fn, int xx, int yy) {
 	options_t& options = *reinterpret_cast<options_t*>(fn);
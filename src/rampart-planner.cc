@@ -0,0 +1,205 @@
+#include <screeps/rampart-planner.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+namespace screeps {
+
+namespace {
+
+// Larger than the sum of every finite tile capacity
+constexpr int32_t k_infinity = 1 << 24;
+
+// Node 2 * index is the tile's "in" node and 2 * index + 1 is its "out" node, so a tile's nodes are
+// adjacent in every per-node array.
+constexpr int k_source = 5000;
+constexpr int k_sink = 5001;
+constexpr int k_nodes = 5002;
+
+// Residual graph in compressed sparse row form. Edges leaving node `ii` are `first[ii]` up to
+// `first[ii + 1]`, and `reverse[edge]` is the paired residual edge.
+class flow_graph_t {
+	public:
+		void add_edge(int from, int to, int32_t capacity) {
+			pending.push_back({from, to, capacity});
+		}
+
+		// Sorts pending edges by their tail into the final arrays
+		void build() {
+			first.fill(0);
+			for (const auto& edge : pending) {
+				++first[edge.from + 1];
+				++first[edge.to + 1];
+			}
+			for (int ii = 0; ii < k_nodes; ++ii) {
+				first[ii + 1] += first[ii];
+			}
+			auto next = first;
+			size_t count = pending.size() * 2;
+			heads.resize(count);
+			capacities.resize(count);
+			reverse.resize(count);
+			for (const auto& edge : pending) {
+				int forward = next[edge.from]++;
+				int backward = next[edge.to]++;
+				heads[forward] = edge.to;
+				capacities[forward] = edge.capacity;
+				reverse[forward] = backward;
+				heads[backward] = edge.from;
+				capacities[backward] = 0;
+				reverse[backward] = forward;
+			}
+			pending.clear();
+		}
+
+		// Dinic's algorithm with an explicit stack instead of recursion, which would be up to 5000
+		// frames deep
+		int32_t max_flow() {
+			int32_t total = 0;
+			std::vector<int> path;
+			while (levels_from_source()) {
+				auto current = first;
+				int node = k_source;
+				while (true) {
+					if (node == k_sink) {
+						int32_t flow = k_infinity;
+						for (int edge : path) {
+							flow = std::min(flow, capacities[edge]);
+						}
+						size_t saturated = path.size();
+						for (size_t ii = path.size(); ii-- > 0;) {
+							capacities[path[ii]] -= flow;
+							capacities[reverse[path[ii]]] += flow;
+							if (capacities[path[ii]] == 0) {
+								saturated = ii;
+							}
+						}
+						total += flow;
+						if (total >= k_infinity) {
+							return total;
+						}
+						// Resume from the tail of the first saturated edge
+						path.resize(saturated);
+						node = path.empty() ? k_source : heads[path.back()];
+						continue;
+					}
+					int& edge = current[node];
+					while (edge < first[node + 1] && (capacities[edge] == 0 || levels[heads[edge]] != levels[node] + 1)) {
+						++edge;
+					}
+					if (edge < first[node + 1]) {
+						path.push_back(edge);
+						node = heads[edge];
+					} else {
+						// Dead end, retreat
+						levels[node] = -1;
+						if (path.empty()) {
+							break;
+						}
+						path.pop_back();
+						node = path.empty() ? k_source : heads[path.back()];
+						++current[node];
+					}
+				}
+			}
+			return total;
+		}
+
+		// After `max_flow`, whether the node is still reachable from the source in the residual graph
+		bool reachable(int node) const {
+			return levels[node] != -1;
+		}
+
+	private:
+		struct pending_edge_t {
+			int from, to;
+			int32_t capacity;
+		};
+		std::vector<pending_edge_t> pending;
+		std::array<int, k_nodes + 1> first;
+		std::vector<int> heads;
+		std::vector<int32_t> capacities;
+		std::vector<int> reverse;
+		std::array<int, k_nodes> levels;
+
+		// Breadth-first levels over edges with remaining capacity. Returns true if the sink is reachable.
+		bool levels_from_source() {
+			levels.fill(-1);
+			std::array<int, k_nodes> queue;
+			int head = 0;
+			int tail = 0;
+			levels[k_source] = 0;
+			queue[tail++] = k_source;
+			while (head != tail) {
+				int node = queue[head++];
+				for (int edge = first[node]; edge < first[node + 1]; ++edge) {
+					if (capacities[edge] > 0 && levels[heads[edge]] == -1) {
+						levels[heads[edge]] = levels[node] + 1;
+						queue[tail++] = heads[edge];
+					}
+				}
+			}
+			return levels[k_sink] != -1;
+		}
+};
+
+bool is_edge(local_position_t pos) {
+	return pos.xx == 0 || pos.xx == 49 || pos.yy == 0 || pos.yy == 49;
+}
+
+} // namespace
+
+std::vector<local_position_t> rampart_planner_t::min_cut(const terrain_t& terrain, const local_matrix_t<bool>& protect, const cost_matrix_t* costs) {
+	// Tiles next to a passable exit are connected to the sink
+	local_matrix_t<bool> near_exit(false);
+	for (auto pos : local_position_t::all()) {
+		if (is_edge(pos) && terrain[pos] != terrain_t::wall) {
+			for (auto neighbor : pos.neighbors()) {
+				near_exit[neighbor] = true;
+			}
+		}
+	}
+
+	flow_graph_t graph;
+	for (auto pos : local_position_t::all()) {
+		if (terrain[pos] == terrain_t::wall || is_edge(pos)) {
+			continue;
+		}
+		int index = pos.xx * 50 + pos.yy;
+		int32_t capacity = 1;
+		if (protect[pos] || near_exit[pos]) {
+			capacity = k_infinity;
+		} else if (costs != nullptr) {
+			uint8_t cost = (*costs)[pos];
+			capacity = cost == 0xff ? k_infinity : std::max<int32_t>(cost, 1);
+		}
+		graph.add_edge(index * 2, index * 2 + 1, capacity);
+		if (protect[pos]) {
+			graph.add_edge(k_source, index * 2, k_infinity);
+		}
+		if (near_exit[pos]) {
+			graph.add_edge(index * 2 + 1, k_sink, k_infinity);
+		}
+		for (auto neighbor : pos.neighbors()) {
+			if (terrain[neighbor] != terrain_t::wall && !is_edge(neighbor)) {
+				graph.add_edge(index * 2 + 1, (neighbor.xx * 50 + neighbor.yy) * 2, k_infinity);
+			}
+		}
+	}
+	graph.build();
+	if (graph.max_flow() >= k_infinity) {
+		throw std::range_error("rampart_planner_t::min_cut");
+	}
+
+	// Tiles whose "in" node is on the source side and "out" node on the sink side
+	std::vector<local_position_t> cut;
+	for (int index = 0; index < 2500; ++index) {
+		if (graph.reachable(index * 2) && !graph.reachable(index * 2 + 1)) {
+			cut.emplace_back(index / 50, index % 50);
+		}
+	}
+	return cut;
+}
+
+} // namespace screeps
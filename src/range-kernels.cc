@@ -0,0 +1,217 @@
+#include <screeps/range-kernels.h>
+#include <climits>
+#include <cstring>
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace screeps::range_kernels {
+
+namespace {
+
+constexpr int32_t k_far = INT_MAX;
+
+int32_t to_int(position_t pos) {
+	int32_t value;
+	std::memcpy(&value, &pos, sizeof(value));
+	return value;
+}
+
+// Each backend works on four packed `position_t`: byte 0 is `xx`, byte 1 is `yy`, and the high 16
+// bits are the room. `chebyshev` takes the per-byte absolute difference, maxes the two coordinate bytes,
+// and substitutes `k_far` where the rooms differ.
+#if defined(__wasm_simd128__)
+#define SCREEPS_RANGE_KERNELS_SIMD
+using vector_t = v128_t;
+
+vector_t load(const position_t* ptr) { return wasm_v128_load(ptr); }
+void store(int32_t* ptr, vector_t value) { wasm_v128_store(ptr, value); }
+vector_t splat(int32_t value) { return wasm_i32x4_splat(value); }
+vector_t iota() { return wasm_i32x4_make(0, 1, 2, 3); }
+vector_t add(vector_t left, vector_t right) { return wasm_i32x4_add(left, right); }
+vector_t sub(vector_t left, vector_t right) { return wasm_i32x4_sub(left, right); }
+vector_t less(vector_t left, vector_t right) { return wasm_i32x4_lt(left, right); }
+vector_t less_equal(vector_t left, vector_t right) { return wasm_i32x4_le(left, right); }
+vector_t select(vector_t mask, vector_t left, vector_t right) { return wasm_v128_bitselect(left, right, mask); }
+int bits(vector_t mask) { return wasm_i32x4_bitmask(mask); }
+
+vector_t chebyshev(vector_t left, vector_t right) {
+	vector_t diff = wasm_v128_or(wasm_u8x16_sub_sat(left, right), wasm_u8x16_sub_sat(right, left));
+	vector_t range = wasm_v128_and(wasm_u8x16_max(diff, wasm_u32x4_shr(diff, 8)), splat(0xff));
+	vector_t same_room = wasm_i32x4_eq(wasm_u32x4_shr(left, 16), wasm_u32x4_shr(right, 16));
+	return select(same_room, range, splat(k_far));
+}
+#elif defined(__SSE2__)
+#define SCREEPS_RANGE_KERNELS_SIMD
+using vector_t = __m128i;
+
+vector_t load(const position_t* ptr) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)); }
+void store(int32_t* ptr, vector_t value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value); }
+vector_t splat(int32_t value) { return _mm_set1_epi32(value); }
+vector_t iota() { return _mm_setr_epi32(0, 1, 2, 3); }
+vector_t add(vector_t left, vector_t right) { return _mm_add_epi32(left, right); }
+vector_t sub(vector_t left, vector_t right) { return _mm_sub_epi32(left, right); }
+vector_t less(vector_t left, vector_t right) { return _mm_cmplt_epi32(left, right); }
+vector_t less_equal(vector_t left, vector_t right) { return _mm_xor_si128(_mm_cmpgt_epi32(left, right), splat(-1)); }
+vector_t select(vector_t mask, vector_t left, vector_t right) { return _mm_or_si128(_mm_and_si128(mask, left), _mm_andnot_si128(mask, right)); }
+int bits(vector_t mask) { return _mm_movemask_ps(_mm_castsi128_ps(mask)); }
+
+vector_t chebyshev(vector_t left, vector_t right) {
+	vector_t diff = _mm_or_si128(_mm_subs_epu8(left, right), _mm_subs_epu8(right, left));
+	vector_t range = _mm_and_si128(_mm_max_epu8(diff, _mm_srli_epi32(diff, 8)), splat(0xff));
+	vector_t same_room = _mm_cmpeq_epi32(_mm_srli_epi32(left, 16), _mm_srli_epi32(right, 16));
+	return select(same_room, range, splat(k_far));
+}
+#endif
+
+#ifdef SCREEPS_RANGE_KERNELS_SIMD
+constexpr size_t k_lanes = 4;
+#else
+constexpr size_t k_lanes = 1;
+#endif
+
+// Number of leading elements handled by the vector loops
+size_t vector_count(size_t count) {
+	return count - count % k_lanes;
+}
+
+} // namespace
+
+void range_to(pointer_container_t<const position_t> positions, position_t target, pointer_container_t<int32_t> ranges) {
+	size_t count = positions.size();
+	size_t ii = 0;
+#ifdef SCREEPS_RANGE_KERNELS_SIMD
+	vector_t target_vector = splat(to_int(target));
+	for (; ii < vector_count(count); ii += k_lanes) {
+		store(&ranges[ii], chebyshev(load(&positions[ii]), target_vector));
+	}
+#endif
+	for (; ii < count; ++ii) {
+		ranges[ii] = positions[ii].range_to(target);
+	}
+}
+
+int within_range(pointer_container_t<const position_t> positions, position_t target, int range, pointer_container_t<uint8_t> mask) {
+	size_t count = positions.size();
+	size_t ii = 0;
+	int total = 0;
+#ifdef SCREEPS_RANGE_KERNELS_SIMD
+	vector_t target_vector = splat(to_int(target));
+	vector_t limit = splat(range);
+	for (; ii < vector_count(count); ii += k_lanes) {
+		int lanes = bits(less_equal(chebyshev(load(&positions[ii]), target_vector), limit));
+		for (size_t lane = 0; lane < k_lanes; ++lane) {
+			mask[ii + lane] = (lanes >> lane) & 1;
+			total += (lanes >> lane) & 1;
+		}
+	}
+#endif
+	for (; ii < count; ++ii) {
+		mask[ii] = positions[ii].range_to(target) <= range;
+		total += mask[ii];
+	}
+	return total;
+}
+
+int count_within_range(pointer_container_t<const position_t> positions, position_t target, int range) {
+	size_t count = positions.size();
+	size_t ii = 0;
+	int total = 0;
+#ifdef SCREEPS_RANGE_KERNELS_SIMD
+	vector_t target_vector = splat(to_int(target));
+	vector_t limit = splat(range);
+	// Comparison lanes are -1 when true
+	vector_t totals = splat(0);
+	for (; ii < vector_count(count); ii += k_lanes) {
+		totals = sub(totals, less_equal(chebyshev(load(&positions[ii]), target_vector), limit));
+	}
+	int32_t lane_totals[k_lanes];
+	store(lane_totals, totals);
+	for (int32_t lane_total : lane_totals) {
+		total += lane_total;
+	}
+#endif
+	for (; ii < count; ++ii) {
+		total += positions[ii].range_to(target) <= range;
+	}
+	return total;
+}
+
+int closest(pointer_container_t<const position_t> positions, position_t target, int32_t* range) {
+	size_t count = positions.size();
+	size_t ii = 0;
+	int best = -1;
+	int32_t best_range = k_far;
+#ifdef SCREEPS_RANGE_KERNELS_SIMD
+	// Track the best range and index in each lane, then reduce. Strict `less` keeps the lowest index
+	// within a lane.
+	vector_t target_vector = splat(to_int(target));
+	vector_t best_ranges = splat(k_far);
+	vector_t best_indices = splat(-1);
+	vector_t indices = iota();
+	for (; ii < vector_count(count); ii += k_lanes) {
+		vector_t candidates = chebyshev(load(&positions[ii]), target_vector);
+		vector_t better = less(candidates, best_ranges);
+		best_ranges = select(better, candidates, best_ranges);
+		best_indices = select(better, indices, best_indices);
+		indices = add(indices, splat(k_lanes));
+	}
+	int32_t lane_ranges[k_lanes];
+	int32_t lane_indices[k_lanes];
+	store(lane_ranges, best_ranges);
+	store(lane_indices, best_indices);
+	for (size_t lane = 0; lane < k_lanes; ++lane) {
+		if (lane_indices[lane] != -1 && (lane_ranges[lane] < best_range || (lane_ranges[lane] == best_range && lane_indices[lane] < best))) {
+			best = lane_indices[lane];
+			best_range = lane_ranges[lane];
+		}
+	}
+#endif
+	for (; ii < count; ++ii) {
+		int32_t candidate = positions[ii].range_to(target);
+		if (candidate < best_range) {
+			best = ii;
+			best_range = candidate;
+		}
+	}
+	if (range != nullptr) {
+		*range = best_range;
+	}
+	return best;
+}
+
+void closest_each(pointer_container_t<const position_t> positions, pointer_container_t<const position_t> targets, pointer_container_t<int32_t> indices, pointer_container_t<int32_t> ranges) {
+	size_t count = positions.size();
+	size_t ii = 0;
+#ifdef SCREEPS_RANGE_KERNELS_SIMD
+	// Four positions at a time against each target in turn
+	for (; ii < vector_count(count); ii += k_lanes) {
+		vector_t position_vector = load(&positions[ii]);
+		vector_t best_ranges = splat(k_far);
+		vector_t best_indices = splat(-1);
+		for (size_t jj = 0; jj < targets.size(); ++jj) {
+			vector_t candidates = chebyshev(position_vector, splat(to_int(targets[jj])));
+			vector_t better = less(candidates, best_ranges);
+			best_ranges = select(better, candidates, best_ranges);
+			best_indices = select(better, splat(jj), best_indices);
+		}
+		store(&ranges[ii], best_ranges);
+		store(&indices[ii], best_indices);
+	}
+#endif
+	for (; ii < count; ++ii) {
+		indices[ii] = -1;
+		ranges[ii] = k_far;
+		for (size_t jj = 0; jj < targets.size(); ++jj) {
+			int32_t candidate = positions[ii].range_to(targets[jj]);
+			if (candidate < ranges[ii]) {
+				indices[ii] = jj;
+				ranges[ii] = candidate;
+			}
+		}
+	}
+}
+
+} // namespace screeps::range_kernels
@@ -124,31 +124,30 @@ int room_t::create_construction_site(local_position_t pos, structure_t::type_t s
 #endif
 }
 
-EMSCRIPTEN_KEEPALIVE
-void room_t::ensure_capacity(room_t* room) {
-	room->invoke_containers([&](auto& container, auto& memory) {
-		memory.ensure_capacity(container);
-	});
-}
-
+// Rooms which JS doesn't write this tick end up with no objects
 void room_t::reset() {
-	invoke_containers([&](auto& container, auto& memory) {
-		memory.reset(container);
-	});
-}
-
-void room_t::shrink() {
-	invoke_containers([&](auto& container, auto& memory) {
-		memory.shrink(container);
-	});
+	creeps_memory = {};
+	dropped_resources_memory = {};
+	sources_memory = {};
+	structures_memory = {};
+	tombstones_memory = {};
 }
 
+// Containers are filled in afterwards by `game_state_t::update_pointers`
 void room_t::update_pointers() {
 	construction_sites = {nullptr, nullptr};
+	creeps = {nullptr, nullptr};
+	dropped_resources = {nullptr, nullptr};
 	flags = {nullptr, nullptr};
+	sources = {nullptr, nullptr};
+	structures = {nullptr, nullptr};
+	tombstones = {nullptr, nullptr};
 	if (mineral != nullptr) {
 		mineral = &mineral_holder;
 	}
+}
+
+void room_t::update_structure_pointers() {
 	controller = nullptr;
 /*
 	storage = nullptr;
@@ -0,0 +1,492 @@
+#include <screeps/route-planner.h>
+#include <screeps/terrain.h>
+#include "./path-cost.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace screeps {
+
+namespace {
+
+using room_graph_t = route_planner_t::room_graph_t;
+using exit_t = route_planner_t::exit_t;
+
+constexpr uint32_t k_unvisited = 0xffffffff;
+// Upper bound on rooms looked at by one route search
+constexpr int k_max_route_rooms = 256;
+
+struct graph_key_t {
+	room_location_t location;
+	int plain_cost;
+	int swamp_cost;
+
+	bool operator==(const graph_key_t& rhs) const {
+		return location == rhs.location && plain_cost == rhs.plain_cost && swamp_cost == rhs.swamp_cost;
+	}
+};
+
+struct graph_key_hash_t {
+	size_t operator()(const graph_key_t& key) const {
+		return std::hash<room_location_t>()(key.location) ^ (key.plain_cost << 16) ^ (key.swamp_cost << 24);
+	}
+};
+
+// Each (room, plain_cost, swamp_cost) gets its own graph. At most `k_max_cached_graphs` are kept,
+// with the most recently used at the front of `lru_graphs`.
+constexpr size_t k_max_cached_graphs = 1024;
+struct graph_entry_t {
+	graph_key_t key;
+	std::shared_ptr<const room_graph_t> graph;
+};
+static std::list<graph_entry_t> lru_graphs;
+static std::unordered_map<graph_key_t, std::list<graph_entry_t>::iterator, graph_key_hash_t> cached_graphs;
+
+struct open_t {
+	uint32_t f;
+	uint32_t g;
+	int id;
+
+	// Inverted because `std::push_heap` builds a max-heap
+	bool operator<(const open_t& rhs) const {
+		return f > rhs.f;
+	}
+};
+
+constexpr bool is_border(int xx, int yy) {
+	return xx == 0 || xx == 49 || yy == 0 || yy == 49;
+}
+
+// Local coordinates of the `ii`th tile along one side of a room
+constexpr local_position_t side_tile(direction_t side, int ii) {
+	switch (side) {
+		case direction_t::top: return {ii, 0};
+		case direction_t::right: return {49, ii};
+		case direction_t::bottom: return {ii, 49};
+		default: return {0, ii};
+	}
+}
+
+constexpr room_location_t room_across(room_location_t room, direction_t side) {
+	switch (side) {
+		case direction_t::top: return {room.xx, room.yy - 1};
+		case direction_t::right: return {room.xx + 1, room.yy};
+		case direction_t::bottom: return {room.xx, room.yy + 1};
+		default: return {room.xx - 1, room.yy};
+	}
+}
+
+// Dijkstra search within a single room. Exit tiles other than the sources are reached but not
+// expanded, since stepping onto one leaves the room.
+std::vector<uint32_t> room_distances(const terrain_t& terrain, const std::vector<int>& sources, const path_finder_t::options_t& options) {
+	std::vector<uint32_t> distances(2500, k_unvisited);
+	std::vector<open_t> open_list;
+	for (int index : sources) {
+		if (distances[index] != 0) {
+			distances[index] = 0;
+			open_list.push_back({0, 0, index});
+		}
+	}
+	while (!open_list.empty()) {
+		std::pop_heap(open_list.begin(), open_list.end());
+		open_t current = open_list.back();
+		open_list.pop_back();
+		if (current.g != distances[current.id]) {
+			continue;
+		}
+		int xx = current.id / 50;
+		int yy = current.id % 50;
+		if (current.g != 0 && is_border(xx, yy)) {
+			continue;
+		}
+		for (auto neighbor : local_position_t(xx, yy).neighbors()) {
+			int index = neighbor.xx * 50 + neighbor.yy;
+			uint32_t cost = internal::tile_cost(terrain, nullptr, index, options);
+			if (cost >= internal::k_obstacle_cost) {
+				continue;
+			}
+			uint32_t distance = current.g + cost;
+			if (distance < distances[index]) {
+				distances[index] = distance;
+				open_list.push_back({distance, distance, index});
+				std::push_heap(open_list.begin(), open_list.end());
+			}
+		}
+	}
+	return distances;
+}
+
+// Cheapest distance to any tile of each exit
+std::vector<uint32_t> exit_distances(const room_graph_t& graph, const std::vector<uint32_t>& distances) {
+	std::vector<uint32_t> result;
+	result.reserve(graph.exits.size());
+	for (auto& exit : graph.exits) {
+		uint32_t best = k_unvisited;
+		for (int ii = exit.begin; ii <= exit.end; ++ii) {
+			local_position_t pos = side_tile(exit.side, ii);
+			best = std::min(best, distances[pos.xx * 50 + pos.yy]);
+		}
+		result.push_back(best);
+	}
+	return result;
+}
+
+// Tiles in range of any goal inside one room
+std::vector<int> goal_tiles(room_location_t room, const path_finder_t::goals_t& goals) {
+	std::vector<int> tiles;
+	for (auto& goal : goals) {
+		if (goal.pos.room != room) {
+			continue;
+		}
+		int range = std::max(goal.range, 0);
+		for (int xx = std::max(goal.pos.xx - range, 0); xx <= std::min(goal.pos.xx + range, 49); ++xx) {
+			for (int yy = std::max(goal.pos.yy - range, 0); yy <= std::min(goal.pos.yy + range, 49); ++yy) {
+				tiles.push_back(xx * 50 + yy);
+			}
+		}
+	}
+	return tiles;
+}
+
+// One room along a route, and the exit used to leave it. The last leg has no exit.
+struct leg_t {
+	room_location_t room;
+	bool leaves;
+	exit_t exit;
+};
+
+class route_search_t {
+	public:
+		route_search_t(const path_finder_t::goals_t& goals, const path_finder_t::options_t& options) :
+			goals(goals), options(options), min_cost(std::max(std::min(options.plain_cost, options.swamp_cost), 1)) {}
+
+		std::vector<leg_t> search(position_t origin) {
+			int origin_room = room_index(origin.room);
+			if (origin_room == -1) {
+				return {};
+			}
+			auto& room = rooms[origin_room];
+			auto distances = room_distances(*terrain_t::load(origin.room), {origin.xx * 50 + origin.yy}, options);
+
+			// Goal in the origin room can be reached directly
+			for (int index : goal_tiles(origin.room, goals)) {
+				if (distances[index] != k_unvisited) {
+					push_goal(distances[index], -1);
+				}
+			}
+			auto to_exits = exit_distances(*room.graph, distances);
+			for (size_t ii = 0; ii < to_exits.size(); ++ii) {
+				if (to_exits[ii] != k_unvisited) {
+					push(room.offset + ii, to_exits[ii], -1);
+				}
+			}
+
+			while (!open_list.empty()) {
+				std::pop_heap(open_list.begin(), open_list.end());
+				open_t current = open_list.back();
+				open_list.pop_back();
+				if (current.id == k_goal) {
+					return unwind(goal_parent);
+				}
+				node_t& node = nodes[current.id];
+				if (node.closed || current.g != node.g) {
+					continue;
+				}
+				node.closed = true;
+				++ops;
+				expand(current.id, current.g);
+			}
+			return {};
+		}
+
+		int ops = 0;
+
+	private:
+		static constexpr int k_goal = -2;
+
+		struct node_t {
+			uint32_t g;
+			int parent;
+			int room;
+			bool closed;
+		};
+
+		struct room_t {
+			room_location_t location;
+			std::shared_ptr<const room_graph_t> graph;
+			std::vector<uint32_t> goal_distances;
+			int offset;
+		};
+
+		const path_finder_t::goals_t& goals;
+		const path_finder_t::options_t& options;
+		uint32_t min_cost;
+		std::vector<room_t> rooms;
+		std::unordered_map<room_location_t, int> room_indices;
+		std::vector<node_t> nodes;
+		std::vector<open_t> open_list;
+		uint32_t goal_g = k_unvisited;
+		int goal_parent = -1;
+
+		// Returns the index of a room in `rooms`, loading it if needed, or -1 if it can't be entered
+		int room_index(room_location_t location) {
+			auto ii = room_indices.find(location);
+			if (ii != room_indices.end()) {
+				return ii->second;
+			}
+			int index = -1;
+			if (
+				static_cast<int>(rooms.size()) < k_max_route_rooms &&
+				(!options.room_callback || options.room_callback(location) != nullptr)
+			) {
+				index = rooms.size();
+				auto graph = route_planner_t::load_graph(location, options.plain_cost, options.swamp_cost);
+				rooms.push_back({location, graph, {}, static_cast<int>(nodes.size())});
+				nodes.resize(nodes.size() + graph->exits.size(), node_t{k_unvisited, -1, index, false});
+				auto tiles = goal_tiles(location, goals);
+				if (!tiles.empty()) {
+					rooms.back().goal_distances = exit_distances(*graph, room_distances(*terrain_t::load(location), tiles, options));
+				}
+			}
+			room_indices.emplace(location, index);
+			return index;
+		}
+
+		uint32_t heuristic(const room_t& room, int exit) const {
+			const exit_t& info = room.graph->exits[exit];
+			position_t middle = info.middle(room.location);
+			int slack = (info.end - info.begin) / 2;
+			uint32_t best = k_unvisited;
+			detail::world_position_t from(middle);
+			for (auto& goal : goals) {
+				detail::world_position_t to(goal.pos);
+				int distance = std::max(
+					std::abs(static_cast<int>(from.xx) - static_cast<int>(to.xx)),
+					std::abs(static_cast<int>(from.yy) - static_cast<int>(to.yy))
+				);
+				best = std::min<uint32_t>(best, std::max(distance - goal.range - slack, 0));
+			}
+			return best * min_cost;
+		}
+
+		void push(int id, uint32_t g, int parent) {
+			node_t& node = nodes[id];
+			if (node.closed || g >= node.g) {
+				return;
+			}
+			node.g = g;
+			node.parent = parent;
+			const room_t& room = rooms[node.room];
+			open_list.push_back({g + heuristic(room, id - room.offset), g, id});
+			std::push_heap(open_list.begin(), open_list.end());
+		}
+
+		void push_goal(uint32_t g, int parent) {
+			if (g < goal_g) {
+				goal_g = g;
+				goal_parent = parent;
+				open_list.push_back({g, g, k_goal});
+				std::push_heap(open_list.begin(), open_list.end());
+			}
+		}
+
+		void expand(int id, uint32_t g) {
+			int room_index = nodes[id].room;
+			int exit = id - rooms[room_index].offset;
+
+			// Finish in this room
+			if (!rooms[room_index].goal_distances.empty()) {
+				uint32_t distance = rooms[room_index].goal_distances[exit];
+				if (distance != k_unvisited) {
+					push_goal(g + distance, id);
+				}
+			}
+
+			// Other exits of this room
+			const room_graph_t& graph = *rooms[room_index].graph;
+			for (size_t ii = 0; ii < graph.exits.size(); ++ii) {
+				uint16_t distance = graph.distance(exit, ii);
+				if (distance != route_planner_t::k_unreachable && static_cast<int>(ii) != exit) {
+					push(rooms[room_index].offset + ii, g + distance, id);
+				}
+			}
+
+			// Across the exit into the next room
+			const exit_t& info = graph.exits[exit];
+			direction_t opposite = info.side + 4;
+			int next_room = this->room_index(room_across(graph.location, info.side));
+			if (next_room != -1) {
+				const room_t& next = rooms[next_room];
+				for (size_t ii = 0; ii < next.graph->exits.size(); ++ii) {
+					const exit_t& candidate = next.graph->exits[ii];
+					if (candidate.side == opposite && candidate.begin == info.begin) {
+						push(next.offset + ii, g + min_cost, id);
+						break;
+					}
+				}
+			}
+		}
+
+		std::vector<leg_t> unwind(int id) {
+			std::vector<int> route;
+			for (; id != -1; id = nodes[id].parent) {
+				route.push_back(id);
+			}
+			std::reverse(route.begin(), route.end());
+
+			std::vector<leg_t> legs;
+			for (size_t ii = 0; ii < route.size(); ++ii) {
+				const room_t& room = rooms[nodes[route[ii]].room];
+				if (ii + 1 < route.size() && nodes[route[ii + 1]].room != nodes[route[ii]].room) {
+					legs.push_back({room.location, true, room.graph->exits[route[ii] - room.offset]});
+				}
+			}
+			room_location_t last = route.empty() ? rooms[0].location : rooms[nodes[route.back()].room].location;
+			legs.push_back({last, false, {}});
+			return legs;
+		}
+};
+
+} // namespace
+
+position_t route_planner_t::exit_t::middle(room_location_t room) const {
+	return {room, side_tile(side, (begin + end) / 2)};
+}
+
+std::shared_ptr<const route_planner_t::room_graph_t> route_planner_t::load_graph(room_location_t room, int plain_cost, int swamp_cost) {
+	graph_key_t key{room, plain_cost, swamp_cost};
+	auto cached = cached_graphs.find(key);
+	if (cached != cached_graphs.end()) {
+		lru_graphs.splice(lru_graphs.begin(), lru_graphs, cached->second);
+		return cached->second->graph;
+	}
+
+	auto terrain = terrain_t::load(room);
+	auto graph = std::make_shared<room_graph_t>();
+	graph->location = room;
+
+	// Find runs of exit tiles. Corners are always walls.
+	for (direction_t side : {direction_t::top, direction_t::right, direction_t::bottom, direction_t::left}) {
+		int begin = -1;
+		for (int ii = 1; ii <= 49; ++ii) {
+			local_position_t pos = side_tile(side, ii);
+			bool passable = ii < 49 && !((*terrain)[pos.xx * 50 + pos.yy] & terrain_t::wall);
+			if (passable && begin == -1) {
+				begin = ii;
+			} else if (!passable && begin != -1) {
+				graph->exits.push_back({side, static_cast<uint8_t>(begin), static_cast<uint8_t>(ii - 1)});
+				begin = -1;
+			}
+		}
+	}
+
+	// Distances between each pair of exits
+	path_finder_t::options_t options;
+	options.plain_cost = plain_cost;
+	options.swamp_cost = swamp_cost;
+	size_t count = graph->exits.size();
+	graph->distances.resize(count * count, k_unreachable);
+	for (size_t from = 0; from < count; ++from) {
+		const exit_t& exit = graph->exits[from];
+		std::vector<int> sources;
+		for (int ii = exit.begin; ii <= exit.end; ++ii) {
+			local_position_t pos = side_tile(exit.side, ii);
+			sources.push_back(pos.xx * 50 + pos.yy);
+		}
+		auto distances = exit_distances(*graph, room_distances(*terrain, sources, options));
+		for (size_t to = 0; to < count; ++to) {
+			graph->distances[from * count + to] = std::min<uint32_t>(distances[to], k_unreachable);
+		}
+	}
+
+	lru_graphs.push_front({key, graph});
+	cached_graphs.emplace(key, lru_graphs.begin());
+	if (lru_graphs.size() > k_max_cached_graphs) {
+		cached_graphs.erase(lru_graphs.back().key);
+		lru_graphs.pop_back();
+	}
+	return graph;
+}
+
+void route_planner_t::flush() {
+	cached_graphs.clear();
+	lru_graphs.clear();
+}
+
+std::vector<room_location_t> route_planner_t::find_route(position_t origin, const path_finder_t::goals_t& goals, const path_finder_t::options_t& options) {
+	std::vector<room_location_t> rooms;
+	for (auto& leg : route_search_t(goals, options).search(origin)) {
+		rooms.push_back(leg.room);
+	}
+	return rooms;
+}
+
+path_finder_t::result_t route_planner_t::search(position_t origin, const path_finder_t::goals_t& goals, const path_finder_t::options_t& options) {
+	if (options.flee) {
+		return path_finder_t::search(origin, goals, options);
+	}
+	route_search_t route_search(goals, options);
+	std::vector<leg_t> legs = route_search.search(origin);
+	if (legs.empty()) {
+		return path_finder_t::search(origin, goals, options);
+	}
+
+	// Each leg is a search confined to one room. Rooms need a cost matrix to be allowed at all.
+	static const cost_matrix_t empty_cost_matrix(0);
+	room_location_t current_room;
+	const cost_matrix_t* current_cost_matrix = nullptr;
+	path_finder_t::options_t leg_options = options;
+	leg_options.max_rooms = 1;
+	leg_options.room_callback = [&](room_location_t room) -> const cost_matrix_t* {
+		return room == current_room ? current_cost_matrix : nullptr;
+	};
+
+	path_finder_t::result_t result;
+	result.path = std::make_unique<path_finder_t::path_t>();
+	result.ops = route_search.ops;
+	result.cost = 0;
+	result.incomplete = false;
+	position_t pos = origin;
+	for (auto& leg : legs) {
+		current_room = leg.room;
+		current_cost_matrix = options.room_callback ? options.room_callback(leg.room) : &empty_cost_matrix;
+		path_finder_t::goals_t leg_goals;
+		if (leg.leaves) {
+			for (int ii = leg.exit.begin; ii <= leg.exit.end; ++ii) {
+				leg_goals.push_back({{leg.room, side_tile(leg.exit.side, ii)}, 0});
+			}
+		}
+		path_finder_t::result_t leg_result = path_finder_t::search(pos, leg.leaves ? leg_goals : goals, leg_options);
+		result.ops += leg_result.ops;
+		result.cost += leg_result.cost;
+		if (
+			leg_result.incomplete ||
+			result.path->size() + leg_result.path->size() + 1 > path_finder_t::path_t::capacity()
+		) {
+			// The room-level distances were wrong about this room, search normally instead
+			path_finder_t::result_t fallback = path_finder_t::search(origin, goals, options);
+			fallback.ops += result.ops;
+			return fallback;
+		}
+		for (auto step : *leg_result.path) {
+			result.path->emplace_back(step);
+		}
+		if (leg_result.path->size() != 0) {
+			pos = (*leg_result.path)[leg_result.path->size() - 1];
+		}
+		if (leg.leaves) {
+			// Step across the exit
+			pos = detail::world_position_t(pos).in_direction(leg.exit.side);
+			result.path->emplace_back(pos);
+			const cost_matrix_t* next_cost_matrix = options.room_callback ? options.room_callback(pos.room) : nullptr;
+			result.cost += internal::tile_cost(*terrain_t::load(pos.room), next_cost_matrix, pos.xx * 50 + pos.yy, options);
+		}
+	}
+	return result;
+}
+
+} // namespace screeps
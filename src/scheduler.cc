@@ -0,0 +1,118 @@
+#include <screeps/scheduler.h>
+#include <screeps/cpu.h>
+#include <algorithm>
+
+namespace screeps::cpu {
+
+int scheduler_t::add(int priority, task_t task, double estimate) {
+	int id = next_id++;
+	// Keep `tasks` sorted by priority, after existing tasks of the same priority
+	auto ii = std::find_if(tasks.begin(), tasks.end(), [&](const entry_t& entry) {
+		return entry.priority < priority;
+	});
+	tasks.insert(ii, {std::move(task), id, priority, estimate, statistics.ticks});
+	return id;
+}
+
+bool scheduler_t::cancel(int id) {
+	auto ii = std::find_if(tasks.begin(), tasks.end(), [&](const entry_t& entry) {
+		return entry.id == id;
+	});
+	if (ii == tasks.end()) {
+		return false;
+	}
+	tasks.erase(ii);
+	return true;
+}
+
+double scheduler_t::budget() const {
+	double limit = get_limit();
+	int bucket = get_bucket();
+	double fraction = 1;
+	if (bucket < options.bucket_low) {
+		fraction = options.low_bucket_fraction;
+	} else if (bucket > options.bucket_high) {
+		fraction = options.burst_fraction;
+	}
+	return std::min(limit * fraction, static_cast<double>(get_tick_limit())) - options.reserve;
+}
+
+void scheduler_t::run() {
+	++statistics.ticks;
+	double threshold = budget();
+	double start = get_used();
+	statistics.budget = threshold;
+
+	// A task whose estimate is more than the whole budget never fits normally. Once the oldest such
+	// task has starved it gets the top of the tick, if the bucket allows a burst that covers it.
+	int burst_id = -1;
+	int oldest = statistics.ticks;
+	if (get_bucket() >= options.bucket_low) {
+		double burst = get_tick_limit() - options.reserve;
+		for (auto& entry : tasks) {
+			if (
+				entry.estimate > threshold - start && start + entry.estimate <= burst &&
+				statistics.ticks - entry.last_run >= options.starvation_ticks && entry.last_run < oldest
+			) {
+				burst_id = entry.id;
+				oldest = entry.last_run;
+			}
+		}
+	}
+
+	// Each task gets at most one slice per tick. Tasks may add or cancel tasks while running, so
+	// entries are found again by id afterwards.
+	std::vector<int> order;
+	order.reserve(tasks.size());
+	if (burst_id != -1) {
+		order.push_back(burst_id);
+	}
+	for (auto& entry : tasks) {
+		if (entry.id != burst_id) {
+			order.push_back(entry.id);
+		}
+	}
+	for (int id : order) {
+		auto entry = std::find_if(tasks.begin(), tasks.end(), [&](const entry_t& entry) {
+			return entry.id == id;
+		});
+		if (entry == tasks.end()) {
+			continue;
+		}
+		double used = get_used();
+		if (used + entry->estimate > threshold && id != burst_id) {
+			++statistics.deferrals;
+			continue;
+		}
+		task_t task = std::move(entry->task);
+		bool finished = task();
+		double cost = get_used() - used;
+		++statistics.slices;
+		entry = std::find_if(tasks.begin(), tasks.end(), [&](const entry_t& entry) {
+			return entry.id == id;
+		});
+		if (entry == tasks.end()) {
+			continue;
+		} else if (finished) {
+			++statistics.completed;
+			tasks.erase(entry);
+		} else {
+			entry->task = std::move(task);
+			entry->estimate = std::max(cost, entry->estimate * 0.75 + cost * 0.25);
+			entry->last_run = statistics.ticks;
+		}
+	}
+	statistics.used = get_used() - start;
+
+	statistics.starved = 0;
+	statistics.longest_wait = 0;
+	for (auto& entry : tasks) {
+		int wait = statistics.ticks - entry.last_run;
+		statistics.longest_wait = std::max(statistics.longest_wait, wait);
+		if (wait >= options.starvation_ticks) {
+			++statistics.starved;
+		}
+	}
+}
+
+} // namespace screeps::cpu
@@ -1,49 +1,130 @@
 #include "./javascript.h"
 #include <screeps/terrain.h>
+#include <list>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace screeps {
 
 namespace {
+	struct cache_entry_t {
+		room_location_t room;
+		std::shared_ptr<terrain_t> terrain;
+	};
+	constexpr int k_entry_size = sizeof(terrain_t) + sizeof(cache_entry_t);
+
+	// Most recently used terrain is at the front of `lru_terrain`
+	static std::list<cache_entry_t> lru_terrain;
+	static std::unordered_map<room_location_t, std::list<cache_entry_t>::iterator> cached_terrain;
 	static std::unordered_map<room_location_t, std::weak_ptr<terrain_t>> weak_terrain;
-	static std::unordered_map<room_location_t, std::shared_ptr<terrain_t>> stored_terrain;
+	static std::unordered_set<room_location_t> pinned_terrain;
+	static terrain_t::cache_statistics_t statistics;
 
 	class public_terrain_t : public terrain_t {
 		public:
 			public_terrain_t(room_location_t room) : terrain_t(room) {}
 	};
+
+	// `std::make_shared` puts the matrix in the same allocation as the control block, so a stale
+	// `weak_ptr` would keep the whole matrix alive.
+	void prune_weak_terrain() {
+		for (auto ii = weak_terrain.begin(); ii != weak_terrain.end(); ) {
+			if (ii->second.expired()) {
+				ii = weak_terrain.erase(ii);
+			} else {
+				++ii;
+			}
+		}
+	}
+
+	void evict_terrain() {
+		auto ii = lru_terrain.end();
+		while (statistics.size > statistics.budget && ii != lru_terrain.begin()) {
+			--ii;
+			if (pinned_terrain.count(ii->room) == 0) {
+				cached_terrain.erase(ii->room);
+				ii = lru_terrain.erase(ii);
+				statistics.size -= k_entry_size;
+				++statistics.evictions;
+			}
+		}
+		if (weak_terrain.size() > cached_terrain.size() * 2) {
+			prune_weak_terrain();
+		}
+	}
+
+	void cache_terrain(room_location_t room, std::shared_ptr<terrain_t> terrain) {
+		auto ii = cached_terrain.find(room);
+		if (ii == cached_terrain.end()) {
+			lru_terrain.push_front({room, std::move(terrain)});
+			cached_terrain.emplace(room, lru_terrain.begin());
+			statistics.size += k_entry_size;
+			evict_terrain();
+		} else {
+			ii->second->terrain = std::move(terrain);
+			lru_terrain.splice(lru_terrain.begin(), lru_terrain, ii->second);
+		}
+	}
 }
 
 void terrain_t::flush() {
-	stored_terrain.clear();
-	for (auto ii = weak_terrain.begin(); ii != weak_terrain.end(); ) {
-		if (ii->second.lock()) {
-			++ii;
+	for (auto ii = lru_terrain.begin(); ii != lru_terrain.end(); ) {
+		if (pinned_terrain.count(ii->room) == 0) {
+			cached_terrain.erase(ii->room);
+			ii = lru_terrain.erase(ii);
+			statistics.size -= k_entry_size;
 		} else {
-			ii = weak_terrain.erase(ii);
+			++ii;
 		}
 	}
+	prune_weak_terrain();
 }
 
 std::shared_ptr<terrain_t> terrain_t::load(room_location_t room) {
+	// Check the cache
+	auto cached = cached_terrain.find(room);
+	if (cached != cached_terrain.end()) {
+		++statistics.hits;
+		lru_terrain.splice(lru_terrain.begin(), lru_terrain, cached->second);
+		return cached->second->terrain;
+	}
+
+	// Evicted terrain may still be referenced elsewhere
 	auto ii = weak_terrain.find(room);
+	std::shared_ptr<terrain_t> ptr;
 	if (ii != weak_terrain.end()) {
-		auto ptr = ii->second.lock();
-		if (ptr) {
-			return ptr;
-		} else {
-			ptr = std::make_shared<public_terrain_t>(room);
-			ii->second = ptr;
-			return ptr;
-		}
+		ptr = ii->second.lock();
 	}
-	auto ptr = std::make_shared<public_terrain_t>(room);
-	stored_terrain.emplace(room, ptr);
-	weak_terrain.emplace(room, ptr);
+	if (ptr) {
+		++statistics.hits;
+	} else {
+		++statistics.misses;
+		ptr = std::make_shared<public_terrain_t>(room);
+		weak_terrain[room] = ptr;
+	}
+	cache_terrain(room, ptr);
 	return ptr;
 }
 
+void terrain_t::pin(room_location_t room) {
+	pinned_terrain.insert(room);
+}
+
+void terrain_t::unpin(room_location_t room) {
+	pinned_terrain.erase(room);
+	evict_terrain();
+}
+
+void terrain_t::set_cache_budget(int bytes) {
+	statistics.budget = bytes;
+	evict_terrain();
+}
+
+const terrain_t::cache_statistics_t& terrain_t::get_cache_statistics() {
+	return statistics;
+}
+
 terrain_t::terrain_t(room_location_t room) {
 	EM_ASM({
 		var roomName = Module.screeps.position.generateRoomName($0);
@@ -74,9 +155,12 @@ terrain_t::terrain_t(room_location_t room) {
 }
 
 void terrain_t::insert(room_location_t room, std::shared_ptr<terrain_t> terrain) {
-	static std::unordered_map<room_location_t, std::shared_ptr<terrain_t>> eternal_terrain;
-	weak_terrain.emplace(room, terrain);
-	eternal_terrain.emplace(room, std::move(terrain));
+#ifndef JAVASCRIPT
+	// Without `Game.map` there's no way to reload this terrain after eviction
+	pinned_terrain.insert(room);
+#endif
+	weak_terrain[room] = terrain;
+	cache_terrain(room, std::move(terrain));
 }
 
 } // namespace screeps
@@ -0,0 +1,122 @@
+#include <screeps/threat-map.h>
+#include <screeps/creep.h>
+#include <screeps/terrain.h>
+#include "./path-cost.h"
+#include <algorithm>
+#include <tuple>
+#include <unordered_map>
+
+namespace screeps {
+
+namespace {
+
+constexpr uint8_t k_max_safety = threat_map_t::k_safe - 1;
+
+static std::unordered_map<room_location_t, std::shared_ptr<const threat_map_t>> cached_maps;
+
+} // namespace
+
+threat_map_t::threat_map_t(room_location_t room, const std::vector<threat_t>& threats, const cost_matrix_t* cost_matrix) :
+		terrain(terrain_t::load(room)),
+		threats(threats),
+		safeties(k_safe) {
+	if (cost_matrix != nullptr) {
+		this->cost_matrix = *cost_matrix;
+	}
+
+	// Tiles in range of a hostile are the first layer. Impassable tiles get a value but aren't expanded.
+	std::vector<local_position_t> frontier;
+	std::vector<local_position_t> next;
+	for (auto& threat : threats) {
+		int range = std::max(threat.range, 0);
+		for (auto pos : threat.pos.within_range(range)) {
+			if (safeties[pos] != 0) {
+				safeties[pos] = 0;
+				if (is_passable(pos)) {
+					frontier.push_back(pos);
+				}
+			}
+		}
+	}
+	for (int safety = 1; !frontier.empty(); safety = std::min<int>(safety + 1, k_max_safety)) {
+		next.clear();
+		for (auto pos : frontier) {
+			for (auto neighbor : pos.neighbors()) {
+				if (safeties[neighbor] == k_safe) {
+					safeties[neighbor] = safety;
+					if (is_passable(neighbor)) {
+						next.push_back(neighbor);
+					}
+				}
+			}
+		}
+		std::swap(frontier, next);
+	}
+}
+
+bool threat_map_t::is_passable(local_position_t pos) const {
+	const cost_matrix_t* matrix = cost_matrix ? &*cost_matrix : nullptr;
+	return internal::tile_cost(*terrain, matrix, pos.xx * 50 + pos.yy, {}) < internal::k_obstacle_cost;
+}
+
+std::optional<direction_t> threat_map_t::flee_direction(local_position_t pos) const {
+	// Safety first, then range from the closest hostile so creeps inside attack range still get a
+	// gradient, then plains over swamps so the creep keeps its distance next tick
+	auto score = [&](local_position_t pos) {
+		int range = 50;
+		for (auto& threat : threats) {
+			range = std::min(range, pos.range_to(threat.pos));
+		}
+		bool plain = !((*terrain)[pos.xx * 50 + pos.yy] & terrain_t::swamp);
+		return std::make_tuple(safeties[pos], range, plain);
+	};
+	std::optional<direction_t> best;
+	auto best_score = score(pos);
+	for (auto neighbor : pos.neighbors()) {
+		if (!is_passable(neighbor)) {
+			continue;
+		}
+		auto neighbor_score = score(neighbor);
+		if (neighbor_score > best_score) {
+			best = pos.direction_to(neighbor);
+			best_score = neighbor_score;
+		}
+	}
+	return best;
+}
+
+std::optional<threat_map_t::threat_t> threat_map_t::threat(const creep_t& creep) {
+	int range = -1;
+	for (auto& part : creep.get_active_bodyparts()) {
+		if (part.hits == 0) {
+			continue;
+		} else if (part.part.type == bodypart_t::ranged_attack) {
+			range = 3;
+			break;
+		} else if (part.part.type == bodypart_t::attack) {
+			range = 1;
+		}
+	}
+	if (range == -1) {
+		return std::nullopt;
+	}
+	return threat_t{~creep.pos, range};
+}
+
+std::shared_ptr<const threat_map_t> threat_map_t::load(room_location_t room, const std::vector<threat_t>& threats, const cost_matrix_t* cost_matrix) {
+	auto& map = cached_maps[room];
+	if (map && map->threats == threats) {
+		const auto& cached_matrix = map->cost_matrix;
+		if (cost_matrix == nullptr ? !cached_matrix : cached_matrix && *cached_matrix == *cost_matrix) {
+			return map;
+		}
+	}
+	map = std::make_shared<threat_map_t>(room, threats, cost_matrix);
+	return map;
+}
+
+void threat_map_t::flush() {
+	cached_maps.clear();
+}
+
+} // namespace screeps
@@ -0,0 +1,193 @@
+#include <screeps/traffic.h>
+#include <screeps/terrain.h>
+#include "./path-cost.h"
+#include <algorithm>
+#include <numeric>
+
+namespace screeps {
+
+namespace {
+
+bool in_room(local_position_t pos) {
+	return pos.xx >= 0 && pos.xx < 50 && pos.yy >= 0 && pos.yy < 50;
+}
+
+// A creep left on an exit tile is moved into the next room by the game
+bool on_edge(local_position_t pos) {
+	return pos.xx == 0 || pos.xx == 49 || pos.yy == 0 || pos.yy == 49;
+}
+
+} // namespace
+
+traffic_planner_t::traffic_planner_t(room_location_t room, const cost_matrix_t* cost_matrix) :
+		terrain(terrain_t::load(room)),
+		cost_matrix(cost_matrix) {}
+
+int traffic_planner_t::add(const agent_t& agent) {
+	agents.push_back(agent);
+	agents.back().length = std::clamp(agent.length, 0, k_window);
+	return agents.size() - 1;
+}
+
+void traffic_planner_t::clear() {
+	agents.clear();
+	states.clear();
+	directions.clear();
+}
+
+void traffic_planner_t::plan() {
+	states.assign(agents.size(), state_t::unplanned);
+	directions.assign(agents.size(), std::nullopt);
+	for (auto& layer : reserved) {
+		layer.fill(0);
+	}
+	for (size_t ii = 0; ii < agents.size(); ++ii) {
+		reserved[0][agents[ii].pos] = ii + 1;
+	}
+
+	// Movers go first, by priority
+	std::vector<int> order(agents.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](int left, int right) {
+		bool left_moves = agents[left].can_move && agents[left].length != 0;
+		bool right_moves = agents[right].can_move && agents[right].length != 0;
+		if (left_moves != right_moves) {
+			return left_moves;
+		}
+		return agents[left].priority > agents[right].priority;
+	});
+
+	// Reserve where each mover intends to be after this tick. These are only used to keep pushed
+	// creeps out of the way; the first step is resolved below.
+	for (int id : order) {
+		const agent_t& agent = agents[id];
+		if (!agent.can_move || agent.length == 0) {
+			break;
+		}
+		local_position_t pos = agent.pos;
+		for (int tt = 1; tt <= agent.length; ++tt) {
+			pos = pos.in_direction(agent.steps[tt - 1]);
+			if (!in_room(pos)) {
+				break;
+			}
+			if (tt > 1) {
+				if (reserved[tt][pos] != 0) {
+					break;
+				}
+				reserved[tt][pos] = id + 1;
+			}
+		}
+	}
+
+	for (int id : order) {
+		if (states[id] == state_t::unplanned) {
+			plan_agent(id);
+		}
+	}
+}
+
+bool traffic_planner_t::is_passable(local_position_t pos) const {
+	return internal::tile_cost(*terrain, cost_matrix, pos.xx * 50 + pos.yy, {}) < internal::k_obstacle_cost;
+}
+
+// Plans the first step of a creep and returns true if it leaves its tile
+bool traffic_planner_t::plan_agent(int id) {
+	states[id] = state_t::planning;
+	const agent_t& agent = agents[id];
+	if (agent.can_move && agent.length != 0) {
+		local_position_t to = agent.pos.in_direction(agent.steps[0]);
+		if (!in_room(to)) {
+			// Leaving through an exit
+			move(id, to);
+			return true;
+		} else if (is_passable(to) && reserved[1][to] == 0) {
+			// Claim the tile first so nothing else takes it while the occupant is moved
+			reserved[1][to] = id + 1;
+			int occupant = reserved[0][to] - 1;
+			if (occupant == -1 || make_room(occupant, id)) {
+				move(id, to);
+				return true;
+			}
+			if (reserved[1][to] == id + 1) {
+				reserved[1][to] = 0;
+			}
+		}
+	}
+	reserved[1][agent.pos] = id + 1;
+	states[id] = state_t::planned;
+	return false;
+}
+
+// Returns true if `id` will be off its tile next tick, planning or pushing it if needed
+bool traffic_planner_t::make_room(int id, int requester) {
+	switch (states[id]) {
+		case state_t::planning:
+			// A cycle of creeps each stepping into the next one's tile, which includes head-on swaps.
+			// Everything in the cycle moves.
+			return true;
+		case state_t::planned:
+			return directions[id].has_value();
+		default:
+			if (agents[id].length != 0 || !agents[id].can_move) {
+				return plan_agent(id);
+			}
+			return push(id, requester);
+	}
+}
+
+// Moves an idle creep to a neighboring tile, preferring tiles that aren't on any upcoming path. Swapping
+// with the requester is the last resort. Exit tiles are never used.
+bool traffic_planner_t::push(int id, int requester) {
+	states[id] = state_t::planning;
+	const agent_t& agent = agents[id];
+	local_position_t best = local_position_t::null;
+	int best_score = k_window + 1;
+	for (auto neighbor : agent.pos.neighbors()) {
+		if (!in_room(neighbor) || on_edge(neighbor) || reserved[1][neighbor] != 0 || !is_passable(neighbor)) {
+			continue;
+		}
+		int occupant = reserved[0][neighbor] - 1;
+		if (
+			occupant != -1 &&
+			states[occupant] != state_t::planning &&
+			!(states[occupant] == state_t::planned && directions[occupant])
+		) {
+			continue;
+		}
+		int score = 0;
+		if (occupant == requester) {
+			score = k_window;
+		} else {
+			for (int tt = 2; tt <= k_window; ++tt) {
+				score += reserved[tt][neighbor] != 0;
+			}
+		}
+		if (score < best_score) {
+			best = neighbor;
+			best_score = score;
+		}
+	}
+	if (best == local_position_t::null) {
+		reserved[1][agent.pos] = id + 1;
+		states[id] = state_t::planned;
+		return false;
+	}
+	move(id, best);
+	for (int tt = 2; tt <= k_window; ++tt) {
+		if (reserved[tt][best] == 0) {
+			reserved[tt][best] = id + 1;
+		}
+	}
+	return true;
+}
+
+void traffic_planner_t::move(int id, local_position_t to) {
+	local_position_t from = agents[id].pos;
+	directions[id] = agents[id].length == 0 ? from.direction_to(to) : agents[id].steps[0];
+	if (in_room(to)) {
+		reserved[1][to] = id + 1;
+	}
+	states[id] = state_t::planned;
+}
+
+} // namespace screeps